@@ -5,7 +5,8 @@
 
 class Parallelogram : public Shape {
 	public:
-		Parallelogram(GLint MatrixId, GLint ColorId);
+		Parallelogram(mgl::ShaderProgram *Shaders, mgl::UniformHandle MatrixId, mgl::UniformHandle ColorId,
+			mgl::MeshPool *Pool);
 };
 
 #endif /* PARALLELOGRAM_HPP */
\ No newline at end of file
@@ -1,52 +1,76 @@
 #include "./Shape.hpp"
+#include <algorithm>
 #include <iostream>
+#include <glm/gtc/packing.hpp>
 
-Shape::Shape(GLint MatrixId, GLint ColorId, std::vector<Vertex> Vertices, std::vector<GLubyte> Indices) {
-    this->Vertices = Vertices;
-    this->Indices = Indices;
-    createBufferObjects();
+/*
+ * Shapes of the same type share one mesh in the pool, so only the first one uploads its vertices,
+ * packed to a quarter of the size of four floats. The mesh is welded and reordered for the vertex cache
+ * on the way in.
+ */
+Shape::Shape(mgl::ShaderProgram *Shaders, mgl::UniformHandle MatrixId, mgl::UniformHandle ColorId,
+    mgl::MeshPool *Pool, const std::string &Name, const std::vector<Vertex> &Vertices,
+    const std::vector<GLubyte> &Indices) {
+    this->Shaders = Shaders;
+    this->Pool = Pool;
+    if (Pool->isMesh(Name)) {
+        this->Mesh = Pool->Meshes[Name];
+    }
+    else {
+        std::vector<PackedVertex> packed;
+        for (const Vertex &v : Vertices) {
+            packed.push_back({ glm::packHalf2x16(glm::vec2(v.XY[0], v.XY[1])) });
+        }
+        mgl::MeshOptimizer optimizer(packed.data(), packed.size(), sizeof(PackedVertex), Indices.data(),
+            Indices.size());
+        optimizer.optimize();
+        this->Mesh = Pool->addMesh(Name, optimizer.Vertices.data(), optimizer.getVertexCount(),
+            optimizer.Indices.data(), optimizer.getIndexCount());
+    }
 	this->MatrixId = MatrixId;
 	this->ColorId = ColorId;
+    this->Bounds = computeBounds(Vertices);
+    for (GLubyte i : Indices) {
+        this->Triangles.push_back(glm::vec2(Vertices[i].XY[0], Vertices[i].XY[1]));
+    }
 }
 
-void Shape::createBufferObjects() {
-    glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
-    {
-        glGenBuffers(2, VBO);
-
-        glBindBuffer(GL_ARRAY_BUFFER, VBO[0]);
-        {
-            glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * Vertices.size(), Vertices.data(), GL_STATIC_DRAW);
-            glEnableVertexAttribArray(POSITION);
-            glVertexAttribPointer(POSITION, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                reinterpret_cast<GLvoid*>(0));
-        }
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, VBO[1]);
-        {
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLubyte) * Indices.size(), Indices.data(),
-                GL_STATIC_DRAW);
-        }
+/*
+ * Bounding sphere around the center of the bounding box, used by the GPU culling pass.
+ */
+glm::vec4 Shape::computeBounds(const std::vector<Vertex> &Vertices) {
+    glm::vec2 lo(Vertices[0].XY[0], Vertices[0].XY[1]), hi = lo;
+    for (const Vertex &v : Vertices) {
+        lo = glm::min(lo, glm::vec2(v.XY[0], v.XY[1]));
+        hi = glm::max(hi, glm::vec2(v.XY[0], v.XY[1]));
     }
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glDeleteBuffers(2, VBO);
+    glm::vec2 center = (lo + hi) * 0.5f;
+    GLfloat radius = 0.0f;
+    for (const Vertex &v : Vertices) {
+        radius = std::max(radius, glm::distance(center, glm::vec2(v.XY[0], v.XY[1])));
+    }
+    return glm::vec4(center, 0.0f, radius);
+}
+
+const mgl::Mesh &Shape::getMesh() const {
+    return this->Mesh;
+}
+
+const glm::vec4 &Shape::getBounds() const {
+    return this->Bounds;
 }
 
-void Shape::destroyBufferObjects() {
-    glBindVertexArray(VAO);
-    glDisableVertexAttribArray(POSITION);
-    glDeleteVertexArrays(1, &VAO);
-    glBindVertexArray(0);
+// Model space triangle list, for picking on the CPU
+const std::vector<glm::vec2> &Shape::getTriangles() const {
+    return this->Triangles;
 }
 
 void Shape::draw(glm::mat4 transform, glm::vec4 color) {
-    glBindVertexArray(this->VAO);
+    Pool->bind();
 
-    glUniformMatrix4fv(this->MatrixId, 1, GL_FALSE, glm::value_ptr(transform));
-    glUniform4fv(this->ColorId, 1, glm::value_ptr(color));
-    glDrawElements(GL_TRIANGLES, Indices.size(), GL_UNSIGNED_BYTE, reinterpret_cast<GLvoid*>(0));
+    Shaders->setUniform(this->MatrixId, transform);
+    Shaders->setUniform(this->ColorId, color);
+    Pool->draw(this->Mesh);
 
-    glBindVertexArray(0);
+    Pool->unbind();
 }
\ No newline at end of file
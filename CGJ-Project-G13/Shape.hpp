@@ -4,26 +4,41 @@
 #include <GL/glew.h>
 #include "../mgl/mgl.hpp"
 
+#include <string>
 #include <vector>
 #include <glm/ext.hpp>
 #include <mglShader.hpp>
+#include <mglMesh.hpp>
 
+// Pieces are planar, so only x and y are given; z = 0 and w = 1 are implied
 typedef struct {
-	GLfloat XYZW[4];
+	GLfloat XY[2];
 } Vertex;
 
+// As stored in the mesh pool: x and y as half floats
+typedef struct {
+	GLuint XY;
+} PackedVertex;
+
+typedef mgl::InstanceData Instance;
+
 class Shape {
 	protected:
-		std::vector<Vertex> Vertices;
-		std::vector<GLubyte> Indices;
-		GLuint VAO, VBO[2];
-		const GLuint POSITION = 0;
-		GLint MatrixId;
-		GLint ColorId;
+		mgl::ShaderProgram *Shaders;
+		mgl::MeshPool *Pool;
+		mgl::Mesh Mesh;
+		glm::vec4 Bounds;
+		std::vector<glm::vec2> Triangles;
+		mgl::UniformHandle MatrixId;
+		mgl::UniformHandle ColorId;
+		static glm::vec4 computeBounds(const std::vector<Vertex> &Vertices);
 	public:
-		Shape(GLint MatrixId, GLint ColorId, std::vector<Vertex> Vertices, std::vector<GLubyte> Indices);
-		void createBufferObjects();
-		void destroyBufferObjects();
+		Shape(mgl::ShaderProgram *Shaders, mgl::UniformHandle MatrixId, mgl::UniformHandle ColorId,
+			mgl::MeshPool *Pool, const std::string &Name,
+			const std::vector<Vertex> &Vertices, const std::vector<GLubyte> &Indices);
+		const mgl::Mesh &getMesh() const;
+		const glm::vec4 &getBounds() const;
+		const std::vector<glm::vec2> &getTriangles() const;
 		void draw(glm::mat4 transform, glm::vec4 color);
 };
 
@@ -5,7 +5,8 @@
 
 class Square : public Shape {
 	public:
-		Square(GLint MatrixId, GLint ColorId);
+		Square(mgl::ShaderProgram *Shaders, mgl::UniformHandle MatrixId, mgl::UniformHandle ColorId,
+			mgl::MeshPool *Pool);
 };
 
 #endif /* SQUARE_HPP */
\ No newline at end of file
@@ -1,8 +1,9 @@
 #include "./Triangle.hpp"
 #include <iostream>
 
-std::vector<Vertex> TVertices = { {-0.5f, -0.5f, 0.0f, 1.0f}, {0.5f, -0.5f, 0.0f, 1.0f}, {-0.5f, 0.5f, 0.0f, 1.0f} };
+std::vector<Vertex> TVertices = { {-0.5f, -0.5f}, {0.5f, -0.5f}, {-0.5f, 0.5f} };
 std::vector<GLubyte> TIndices = { 0, 1, 2 };
 
-Triangle::Triangle(GLint MatrixId, GLint ColorId) :
-    Shape(MatrixId, ColorId, TVertices, TIndices) {}
+Triangle::Triangle(mgl::ShaderProgram *Shaders, mgl::UniformHandle MatrixId, mgl::UniformHandle ColorId,
+    mgl::MeshPool *Pool) :
+    Shape(Shaders, MatrixId, ColorId, Pool, "Triangle", TVertices, TIndices) {}
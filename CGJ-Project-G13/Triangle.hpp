@@ -5,7 +5,8 @@
 
 class Triangle : public Shape {
 	public:
-		Triangle(GLint MatrixId, GLint ColorId);
+		Triangle(mgl::ShaderProgram *Shaders, mgl::UniformHandle MatrixId, mgl::UniformHandle ColorId,
+			mgl::MeshPool *Pool);
 };
 
 #endif /* TRIANGLE_HPP */
\ No newline at end of file
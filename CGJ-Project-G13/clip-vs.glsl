@@ -7,7 +7,12 @@ out vec4 exColor;
 uniform mat4 Matrix;
 uniform vec4 Color;
 
+layout(std140) uniform Camera {
+    mat4 ViewMatrix;
+    mat4 ProjectionMatrix;
+};
+
 void main(void) {
-    gl_Position = Matrix * inPosition;
+    gl_Position = ProjectionMatrix * ViewMatrix * Matrix * inPosition;
     exColor = Color;
 }
@@ -0,0 +1,63 @@
+#version 430 core
+
+layout(local_size_x = 64) in;
+
+struct Instance {
+    mat4 Matrix;
+    vec4 Color;
+    vec4 Bounds;
+    uint Mesh;
+};
+
+struct DrawCommand {
+    uint Count;
+    uint InstanceCount;
+    uint FirstIndex;
+    int BaseVertex;
+    uint BaseInstance;
+};
+
+layout(std430, binding = 0) readonly buffer Instances {
+    Instance instances[];
+};
+
+layout(std430, binding = 1) writeonly buffer Visible {
+    uint visible[];
+};
+
+layout(std430, binding = 2) buffer Commands {
+    DrawCommand commands[];
+};
+
+layout(std140) uniform Camera {
+    mat4 ViewMatrix;
+    mat4 ProjectionMatrix;
+};
+
+// Bounding sphere against the six planes of the view frustum
+bool isVisible(vec3 center, float radius) {
+    mat4 m = transpose(ProjectionMatrix * ViewMatrix);
+    vec4 planes[6] = vec4[6](m[3] + m[0], m[3] - m[0], m[3] + m[1],
+                             m[3] - m[1], m[3] + m[2], m[3] - m[2]);
+    for (int i = 0; i < 6; i++) {
+        if (dot(planes[i].xyz, center) + planes[i].w < -radius * length(planes[i].xyz)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void main(void) {
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= uint(instances.length())) {
+        return;
+    }
+    Instance instance = instances[i];
+    vec3 center = (instance.Matrix * vec4(instance.Bounds.xyz, 1.0)).xyz;
+    float scale = max(length(instance.Matrix[0].xyz),
+                      max(length(instance.Matrix[1].xyz), length(instance.Matrix[2].xyz)));
+    if (isVisible(center, instance.Bounds.w * scale)) {
+        uint slot = atomicAdd(commands[instance.Mesh].InstanceCount, 1u);
+        visible[commands[instance.Mesh].BaseInstance + slot] = i;
+    }
+}
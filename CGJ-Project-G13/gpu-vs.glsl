@@ -0,0 +1,32 @@
+#version 430 core
+#extension GL_ARB_shader_draw_parameters : require
+
+in vec4 inPosition;
+
+out vec4 exColor;
+
+struct Instance {
+    mat4 Matrix;
+    vec4 Color;
+    vec4 Bounds;
+    uint Mesh;
+};
+
+layout(std430, binding = 0) readonly buffer Instances {
+    Instance instances[];
+};
+
+layout(std430, binding = 1) readonly buffer Visible {
+    uint visible[];
+};
+
+layout(std140) uniform Camera {
+    mat4 ViewMatrix;
+    mat4 ProjectionMatrix;
+};
+
+void main(void) {
+    Instance instance = instances[visible[gl_BaseInstanceARB + gl_InstanceID]];
+    gl_Position = ProjectionMatrix * ViewMatrix * instance.Matrix * inPosition;
+    exColor = instance.Color;
+}
@@ -0,0 +1,17 @@
+#version 330 core
+
+in vec4 inPosition;
+in vec4 inColor;
+in mat4 inModelMatrix;
+
+out vec4 exColor;
+
+layout(std140) uniform Camera {
+    mat4 ViewMatrix;
+    mat4 ProjectionMatrix;
+};
+
+void main(void) {
+    gl_Position = ProjectionMatrix * ViewMatrix * inModelMatrix * inPosition;
+    exColor = inColor;
+}
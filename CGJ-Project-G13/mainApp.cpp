@@ -9,10 +9,34 @@
 //
 // Key Concepts Demonstrated:
 // - Vertex Array Objects (VAOs) and Vertex Buffer Objects (VBOs)
+// - Packed vertex formats described by vertex layouts
 // - Shader program creation and management
 // - Attribute and uniform handling
 // - Basic transformation matrices
+// - Transform hierarchy with group nodes and incremental updates
 // - Clip space rendering without model/view/projection matrices
+// - Instanced rendering with per-instance attributes
+// - Draw commands recorded by worker threads, sorted and replayed on the GL thread
+// - Draw items sorted by state key and merged into batches by a render queue
+// - GPU-driven rendering: compute shader frustum culling into a multi-draw indirect buffer
+// - Render path chosen with --path direct|instanced|recorded|queued|gpu or cycled with 'P'
+// - Boards of many figures with --grid N
+// - Camera uniform block streamed through a persistently mapped buffer ring
+// - Redundant GL state changes dropped by a state cache
+// - Pieces under the cursor found on the CPU with a bounding volume hierarchy and highlighted
+// - Pieces dragged with the mouse, overlaps found by sweep and prune and separating axis tests
+// - Fixed timestep updates with interpolated display, dragged pieces following the cursor smoothly
+//   with --fixed-step HZ
+// - Input events queued lock-free, coalesced and delivered once per frame, received on their own thread
+//   with --input-thread
+// - GL debug messages logged from a background thread, rate limited per id, with --gl-debug-async N
+// - Dynamic resolution: the scene drawn offscreen at a scale kept within a GPU time budget, then upscaled
+//   with a blit or an edge-aware filter, with --dynamic-resolution MS and --upscale bilinear|edge
+// - Frames read back through a ring of pixel buffer objects and fences, encoded to PNG files or a Y4M video
+//   by background threads, with --capture PATH
+// - Rendering on demand with --on-demand, redrawing only the damaged area with --partial-redraw
+// - Binary scene files memory-mapped and uploaded without copies with --scene,
+//   written from the current board with --save-scene
 //
 // Copyright (c) 2013-25 by Carlos Martinho
 //
@@ -25,33 +49,109 @@
 #include "./Triangle.hpp"
 #include "./Square.hpp"
 #include "./Parallelogram.hpp"
+#include <cstddef>
+#include <cstdlib>
 #include <vector>
 #include <iostream>
+#include <string>
+#include <algorithm>
+#include <cmath>
 
 ////////////////////////////////////////////////////////////////////////// MYAPP
 
+typedef struct {
+    glm::mat4 ViewMatrix;
+    glm::mat4 ProjectionMatrix;
+} CameraBlock;
+
+enum class RenderPath { DIRECT, INSTANCED, RECORDED, QUEUED, GPU };
+
+const int RENDER_PATHS = 5;
+
+const char* RenderPathNames[] = { "direct", "instanced", "recorded", "queued", "gpu" };
+
 class MyApp : public mgl::App {
 public:
-    MyApp() = default;
+    MyApp(RenderPath path, int grid, unsigned int threads, const char* scene, const char* save_scene)
+        : Path(path), Grid(grid), Threads(threads), Scene(scene), SaveScene(save_scene) {}
     ~MyApp() override = default;
+    void setDynamicResolution(double target_ms, mgl::DynamicResolution::Filter filter);
+    void setFixedStep(double hz);
 
     void initCallback(GLFWwindow* win) override;
+    void updateCallback(GLFWwindow* win, double step) override;
     void displayCallback(GLFWwindow* win, double elapsed) override;
     void windowCloseCallback(GLFWwindow* win) override;
     void windowSizeCallback(GLFWwindow* win, int width, int height) override;
+    void keyCallback(GLFWwindow* win, int key, int scancode, int action, int mods) override;
+    void cursorCallback(GLFWwindow* win, double xpos, double ypos) override;
+    void mouseButtonCallback(GLFWwindow* win, int button, int action, int mods) override;
 
 private:
     Triangle *triangle;
     Square *square;
     Parallelogram *parallelogram;
-    const GLuint POSITION = 0, COLOR = 1;
+    Shape *pieces[7];
+    const GLuint POSITION = 0, COLOR = 1, MATRIX = 2;
+    const GLuint CAMERA_BINDING = 0;
     std::unique_ptr<mgl::ShaderProgram> Shaders = nullptr;
-    GLint MatrixId, ColorId;
+    std::unique_ptr<mgl::ShaderProgram> InstancedShaders = nullptr;
+    std::unique_ptr<mgl::ShaderProgram> GpuShaders = nullptr;
+    std::unique_ptr<mgl::ShaderProgram> CullShaders = nullptr;
+    std::unique_ptr<mgl::ShaderProgram> UpscaleShaders = nullptr;
+    std::unique_ptr<mgl::MeshPool> Meshes = nullptr;
+    std::unique_ptr<mgl::UniformBufferRing> UniformBuffers = nullptr;
+    CameraBlock Camera = { glm::mat4(1.0f), glm::mat4(1.0f) };
+    mgl::UniformHandle MatrixId, ColorId;
+    RenderPath Path;
+    int Grid;
+    unsigned int Threads;
+    const char* Scene;
+    const char* SaveScene;
+    mgl::TransformHierarchy Transforms;
+    std::vector<mgl::TransformNode> FigureNodes;
+    std::vector<mgl::TransformNode> Pieces;
+    GLuint InstanceVBO;
+    std::vector<Instance> Instances;
+    std::vector<mgl::SceneMesh> Batches;
+    std::unique_ptr<mgl::WorkerPool> Workers = nullptr;
+    std::unique_ptr<mgl::CommandBuffer> Commands = nullptr;
+    std::unique_ptr<mgl::RenderQueue> Queue = nullptr;
+    std::unique_ptr<mgl::IndirectRenderer> Indirect = nullptr;
+    std::unique_ptr<mgl::DynamicResolution> Resolution = nullptr;
+    double ResolutionMs = 0.0;
+    mgl::DynamicResolution::Filter ResolutionFilter = mgl::DynamicResolution::BILINEAR;
+    GLuint MeshIds[3];
+    std::vector<mgl::GpuInstance> GpuInstances;
+    mgl::PickingIndex Picking;
+    GLuint Hovered = mgl::PickingIndex::NONE;
+    mgl::CollisionWorld Collisions;
+    GLuint Dragged = mgl::PickingIndex::NONE;
+    bool DragOverlap = false;
+    glm::vec2 DragPoint;
+    glm::vec2 DragTarget, DragPrevious, DragCurrent;
+    bool FixedStep = false;
+    glm::dvec2 Cursor = glm::dvec2(0.0);
     void createShaderProgram();
     void createBufferObjects();
     void destroyBufferObjects();
     void drawScene();
+    void drawSceneInstanced();
+    void drawSceneRecorded();
+    void drawSceneQueued();
+    void drawSceneGpu();
     void createTransformations();
+    void createBoard();
+    void createInstances();
+    void loadScene();
+    void saveScene();
+    void updateCamera();
+    const glm::mat4& pieceMatrix(size_t figure, size_t piece) const;
+    const glm::vec4& pieceColor(size_t figure, size_t piece) const;
+    void refreshInstance(GLuint instance);
+    void damagePiece(GLuint instance);
+    void dragPiece(GLuint instance, const glm::vec2& delta);
+    glm::vec2 cursorToWorld(double xpos, double ypos) const;
 };
 
 //////////////////////////////////////////////////////////////////////// SHADERs
@@ -65,88 +165,362 @@ void MyApp::createShaderProgram() {
     Shaders->addAttribute(mgl::COLOR_ATTRIBUTE, COLOR);
     Shaders->addUniform("Matrix");
     Shaders->addUniform("Color");
+    Shaders->addUniformBlock(mgl::CAMERA_BLOCK, CAMERA_BINDING);
+
+    Shaders->createAsync();
+
+    MatrixId = Shaders->getUniformHandle("Matrix");
+    ColorId = Shaders->getUniformHandle("Color");
+
+    // Same scene, but matrix and color come from per-instance attributes
+    InstancedShaders = std::make_unique<mgl::ShaderProgram>();
+    InstancedShaders->addShader(GL_VERTEX_SHADER, "instanced-vs.glsl");
+    InstancedShaders->addShader(GL_FRAGMENT_SHADER, "clip-fs.glsl");
+
+    InstancedShaders->addAttribute(mgl::POSITION_ATTRIBUTE, POSITION);
+    InstancedShaders->addAttribute(mgl::COLOR_ATTRIBUTE, COLOR);
+    InstancedShaders->addAttribute(mgl::MODEL_MATRIX_ATTRIBUTE, MATRIX);
+    InstancedShaders->addUniformBlock(mgl::CAMERA_BLOCK, CAMERA_BINDING);
+
+    InstancedShaders->createAsync();
+
+    // GPU-driven path: instances and draw commands come from storage buffers
+    if (mgl::IndirectRenderer::isSupported()) {
+        GpuShaders = std::make_unique<mgl::ShaderProgram>();
+        GpuShaders->addShader(GL_VERTEX_SHADER, "gpu-vs.glsl");
+        GpuShaders->addShader(GL_FRAGMENT_SHADER, "clip-fs.glsl");
+        GpuShaders->addAttribute(mgl::POSITION_ATTRIBUTE, POSITION);
+        GpuShaders->addUniformBlock(mgl::CAMERA_BLOCK, CAMERA_BINDING);
+        GpuShaders->createAsync();
+
+        CullShaders = std::make_unique<mgl::ShaderProgram>();
+        CullShaders->addShader(GL_COMPUTE_SHADER, "cull-cs.glsl");
+        CullShaders->addUniformBlock(mgl::CAMERA_BLOCK, CAMERA_BINDING);
+        CullShaders->createAsync();
+    }
 
-    Shaders->create();
+    // Full screen pass from the dynamic resolution framebuffer to the window
+    if (ResolutionMs > 0.0 && ResolutionFilter == mgl::DynamicResolution::EDGE_AWARE) {
+        UpscaleShaders = std::make_unique<mgl::ShaderProgram>();
+        UpscaleShaders->addShader(GL_VERTEX_SHADER, "upscale-vs.glsl");
+        UpscaleShaders->addShader(GL_FRAGMENT_SHADER, "upscale-fs.glsl");
+        UpscaleShaders->addUniform("SourceSize");
+        UpscaleShaders->addUniform("TextureSize");
+        UpscaleShaders->createAsync();
+    }
 
-    MatrixId = Shaders->Uniforms["Matrix"].index;
-    ColorId = Shaders->Uniforms["Color"].index;
+    if (mgl::ShaderProgram::CacheHits + mgl::ShaderProgram::CacheMisses > 0) {
+        std::cout << "Shader cache: " << mgl::ShaderProgram::CacheHits << " hits, "
+            << mgl::ShaderProgram::CacheMisses << " misses" << std::endl;
+    }
 }
 
 //////////////////////////////////////////////////////////////////// VAOs & VBOs
 
 void MyApp::createBufferObjects() {
-    triangle = new Triangle(MatrixId, ColorId);
-    square = new Square(MatrixId, ColorId);
-    parallelogram = new Parallelogram(MatrixId, ColorId);
+    mgl::VertexLayout vertices;
+    vertices.add(POSITION, mgl::VertexFormat::HALF2, offsetof(PackedVertex, XY));
+    mgl::VertexLayout instances;
+    instances.add(COLOR, mgl::VertexFormat::FLOAT4, offsetof(Instance, color));
+    for (GLuint i = 0; i < 4; i++) {
+        instances.add(MATRIX + i, mgl::VertexFormat::FLOAT4, offsetof(Instance, matrix) + sizeof(glm::vec4) * i);
+    }
+    instances.setStride(sizeof(Instance));
+    Meshes = std::make_unique<mgl::MeshPool>(vertices, instances);
+    glGenBuffers(1, &InstanceVBO);
+    if (Scene) loadScene();
+
+    triangle = new Triangle(Shaders.get(), MatrixId, ColorId, Meshes.get());
+    square = new Square(Shaders.get(), MatrixId, ColorId, Meshes.get());
+    parallelogram = new Parallelogram(Shaders.get(), MatrixId, ColorId, Meshes.get());
+    if (!Scene) Meshes->create();
+    for (int i = 0; i < 5; i++) pieces[i] = triangle;
+    pieces[5] = square;
+    pieces[6] = parallelogram;
+
+    Workers = std::make_unique<mgl::WorkerPool>(Threads);
+    Commands = std::make_unique<mgl::CommandBuffer>(Meshes.get(), Workers->size());
+    Queue = std::make_unique<mgl::RenderQueue>(Meshes.get());
+    if (mgl::IndirectRenderer::isSupported()) {
+        Indirect = std::make_unique<mgl::IndirectRenderer>(Meshes.get());
+        MeshIds[0] = Indirect->addMesh(triangle->getMesh());
+        MeshIds[1] = Indirect->addMesh(square->getMesh());
+        MeshIds[2] = Indirect->addMesh(parallelogram->getMesh());
+    }
+
+    UniformBuffers = std::make_unique<mgl::UniformBufferRing>(sizeof(CameraBlock));
 }
 
 void MyApp::destroyBufferObjects() {
-    triangle->destroyBufferObjects();
-    square->destroyBufferObjects();
-    parallelogram->destroyBufferObjects();
     delete triangle;
     delete square;
     delete parallelogram;
+    mgl::StateCache::getInstance().forgetBuffer(InstanceVBO);
+    glDeleteBuffers(1, &InstanceVBO);
+    Commands.reset();
+    Queue.reset();
+    Indirect.reset();
+    Workers.reset();
+    Meshes.reset();
+    UniformBuffers.reset();
 }
 
 //////////////////////////////////////////////////////////////////// MATRICES
 
-std::vector<glm::mat4> matrices(7, glm::mat4(1.0f));
+const size_t PIECES = 7;
+
+std::vector<glm::vec4> colors = {
+    glm::vec4((15.0 / 255), (130.0 / 255), (242.0 / 255), 1.0f),    //Large blue triangle
+    glm::vec4((205.0 / 255), (14.0 / 255), (102.0 / 255), 1.0f),    //Large magenta triangle
+    glm::vec4((109.0 / 255), (59.0 / 255), (191.0 / 255), 1.0f),    //Medium purple triangle
+    glm::vec4((0.0 / 255), (158.0 / 255), (166.0 / 255), 1.0f),     //Small teal triangle
+    glm::vec4((235.0 / 255), (71.0 / 255), (38.0 / 255), 1.0f),     //Small orange triangle
+    glm::vec4((34.0 / 255), (171.0 / 255), (36.0 / 255), 1.0f),     //Green square
+    glm::vec4((253.0 / 255), (140.0 / 255), (0.0 / 255), 1.0f)      //Orange parallelogram
+};
 
 /*
- * The first transformation in code is the first transformation applied to the piece.
+ * Each piece is described by its translation, rotation and scale, which are applied in the reverse order:
+ * first the piece is scaled, then rotated around the Z axis, then translated.
  * Eg. the large blue triangle first rotates -135 degrees around Z axis, then translates by (sqrt(2)/2, -sqrt(2)/2, 0).
- * This was done to make code easier to write and to understand, together with having one transformation per line.
- * 
+ *
  * To create the tangram shape, first step is to scale pieces appropriately, then rotate, then translate.
  * This ensures that all the pieces are in the correct position relative to each other.
- * 
- * Once this is done, there is an additional scaling, rotation and translation done to all pieces equally ('for loop')
- * Scaling and translation ensure all pieces fit cleanly in clipspace.
+ *
+ * The pieces are children of a tangram node holding an additional scaling, rotation and translation shared by all
+ * pieces. Scaling and translation ensure all pieces fit cleanly in clipspace.
  * The rotation tilts the entire "Sea Dinosaur" shape slightly upwards.
- * These transformations are applied after individual pieces transformations, meaning they change the "Sea Dinosaur"
- * shape rather than individual pieces.
+ * This transformation is applied after individual pieces transformations, meaning it changes the "Sea Dinosaur"
+ * shape rather than individual pieces, and it is set once instead of being multiplied into every piece.
  */
 void MyApp::createTransformations() {
+    const float r2 = std::sqrt(2.0f);
+    const glm::vec3 Z(0.0f, 0.0f, 1.0f);
+    const glm::vec3 small(0.5f, 0.5f, 1.0f);
+    const struct { glm::vec3 translation; float angle; glm::vec3 scale; } pieceTRS[PIECES] = {
+        { glm::vec3(r2 / 2, -r2 / 2, 0.0f), -135.0f, glm::vec3(1.0f) },          // Large blue triangle
+        { glm::vec3(0.0f), 45.0f, glm::vec3(1.0f) },                             // Large magenta triangle
+        { glm::vec3(-r2 / 4, -r2 / 4, 0.0f), 0.0f, glm::vec3(r2 / 2, r2 / 2, 0.0f) }, // Medium purple triangle
+        { glm::vec3(-r2 / 4, -r2 / 2, 0.0f), 45.0f, small },                     // Small teal triangle
+        { glm::vec3(-r2 / 2 - 1.25f, 0.25f, 0.0f), 90.0f, small },               // Small orange triangle
+        { glm::vec3(-r2 / 2 - 0.75f, 0.25f, 0.0f), 0.0f, small },                // Green square
+        { glm::vec3(-r2 / 2 - 0.25f, 0.0f, 0.0f), 90.0f, small }                 // Orange parallelogram
+    };
+
+    Pieces.clear();
+    for (const mgl::TransformNode& figure : FigureNodes) {
+        // Universal transformation applied to the entire figure
+        mgl::TransformNode tangram = Transforms.addNode(figure);
+        Transforms.setTransform(tangram, glm::vec3(0.25f, 0.0f, 0.0f),
+            glm::angleAxis(glm::radians(-11.0f), Z), small);
+        for (size_t i = 0; i < PIECES; i++) {
+            mgl::TransformNode piece = Transforms.addNode(tangram);
+            Transforms.setTransform(piece, pieceTRS[i].translation,
+                glm::angleAxis(glm::radians(pieceTRS[i].angle), Z), pieceTRS[i].scale);
+            Pieces.push_back(piece);
+        }
+    }
+    Transforms.update();
+}
 
-    glm::mat4 I = glm::mat4(1.0f); // Identity matrix
+/*
+ * The figure is repeated on a Grid x Grid board, each copy scaled down to fit its cell.
+ * With a 1x1 board the figure transform is the identity, which gives the original scene.
+ * Each figure is a root node, so moving a whole figure is a single node update.
+ */
+void MyApp::createBoard() {
+    float cell = 2.0f / Grid;
+
+    Transforms.clear();
+    FigureNodes.clear();
+    for (int row = 0; row < Grid; row++) {
+        for (int col = 0; col < Grid; col++) {
+            glm::vec3 center(-1.0f + cell * (col + 0.5f), -1.0f + cell * (row + 0.5f), 0.0f);
+            mgl::TransformNode figure = Transforms.addNode();
+            Transforms.setTransform(figure, center, glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                glm::vec3(1.0f / Grid, 1.0f / Grid, 1.0f));
+            FigureNodes.push_back(figure);
+        }
+    }
+}
+
+const glm::mat4& MyApp::pieceMatrix(size_t figure, size_t piece) const {
+    return Transforms.getWorld(Pieces[figure * PIECES + piece]);
+}
 
-    // Large blue triangle
-    matrices[0] = glm::rotate(I, glm::radians(-135.0f), glm::vec3(0.0f, 0.0f, 1.0f)) * matrices[0];
-    matrices[0] = glm::translate(I, glm::vec3(std::sqrt(2) / 2, -sqrt(2) / 2, 0)) * matrices[0];
+/*
+ * All pieces live in one instance buffer, grouped by mesh type: the triangles of every figure first (pieces 0-4),
+ * then the squares (5) and the parallelograms (6). Each type is then drawn with a single instanced draw call over
+ * its range. The scene is static, so this is done once after createBoard() and createTransformations().
+ */
+void MyApp::createInstances() {
+    Instances.clear();
+    for (size_t i = 0; i < PIECES; i++) {
+        for (size_t f = 0; f < FigureNodes.size(); f++) {
+            Instances.push_back({ pieceMatrix(f, i), colors[i] });
+        }
+    }
+    // Pieces of the same shape are contiguous, so each shape is one instanced batch
+    GLuint figures = static_cast<GLuint>(FigureNodes.size());
+    Batches.clear();
+    Batches.push_back({ {}, triangle->getMesh().baseVertex, triangle->getMesh().firstIndex,
+        static_cast<GLuint>(triangle->getMesh().count), 0, 5 * figures, {} });
+    Batches.push_back({ {}, square->getMesh().baseVertex, square->getMesh().firstIndex,
+        static_cast<GLuint>(square->getMesh().count), 5 * figures, figures, {} });
+    Batches.push_back({ {}, parallelogram->getMesh().baseVertex, parallelogram->getMesh().firstIndex,
+        static_cast<GLuint>(parallelogram->getMesh().count), 6 * figures, figures, {} });
+
+    if (Indirect) {
+        GpuInstances.clear();
+        for (size_t i = 0; i < Instances.size(); i++) {
+            size_t piece = i / FigureNodes.size();
+            GLuint mesh = MeshIds[piece < 5 ? 0 : piece - 4];
+            GpuInstances.push_back({ Instances[i].matrix, Instances[i].color, pieces[piece]->getBounds(), mesh, {} });
+        }
+        Indirect->setInstances(GpuInstances.data(), static_cast<GLuint>(GpuInstances.size()));
+    }
+    mgl::StateCache &state = mgl::StateCache::getInstance();
+    state.bindBuffer(GL_ARRAY_BUFFER, InstanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(Instance) * Instances.size(), Instances.data(), GL_DYNAMIC_DRAW);
+    state.bindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Picking items are numbered like the instances, so a hit indexes both buffers
+    Picking.clear();
+    const Shape* shapes[] = { triangle, square, parallelogram };
+    for (const Shape* shape : shapes) {
+        Picking.addShape(shape->getTriangles().data(), static_cast<GLuint>(shape->getTriangles().size()));
+    }
+    for (size_t i = 0; i < Instances.size(); i++) {
+        size_t piece = i / FigureNodes.size();
+        Picking.addItem(piece < 5 ? 0 : static_cast<GLuint>(piece - 4), Instances[i].matrix);
+    }
+    Picking.update();
+    Hovered = mgl::PickingIndex::NONE;
 
-    // Large magenta triangle
-    matrices[1] = glm::rotate(I, glm::radians(45.0f), glm::vec3(0.0f, 0.0f, 1.0f)) * matrices[1];
+    // Collision bodies are numbered the same way
+    Collisions.clear();
+    for (const Shape* shape : shapes) {
+        Collisions.addShape(shape->getTriangles().data(), static_cast<GLuint>(shape->getTriangles().size()));
+    }
+    for (size_t i = 0; i < Instances.size(); i++) {
+        size_t piece = i / FigureNodes.size();
+        Collisions.addBody(piece < 5 ? 0 : static_cast<GLuint>(piece - 4), Instances[i].matrix);
+    }
+    Collisions.update();
+    Dragged = mgl::PickingIndex::NONE;
+}
 
-    // Medium purple triangle
-    matrices[2] = glm::scale(I, glm::vec3(std::sqrt(2) / 2, std::sqrt(2) / 2, 0.0f)) * matrices[2];
-    matrices[2] = glm::translate(I, glm::vec3(-std::sqrt(2) / 4, -std::sqrt(2) / 4, 0.0f)) * matrices[2];
+const glm::vec4& MyApp::pieceColor(size_t figure, size_t piece) const {
+    return Instances[piece * FigureNodes.size() + figure].color;
+}
 
-    // Small teal triangle
-    matrices[3] = glm::scale(I, glm::vec3(0.5f, 0.5f, 1.0f)) * matrices[3];
-    matrices[3] = glm::rotate(I, glm::radians(45.0f), glm::vec3(0.0f, 0.0f, 1.0f)) * matrices[3];
-    matrices[3] = glm::translate(I, glm::vec3(-std::sqrt(2) / 4, -std::sqrt(2) / 2, 0.0f)) * matrices[3];
+/*
+ * Asks the engine to redraw the piece's screen rectangle, grown by a pixel for rasterization rounding.
+ * Has no effect unless the engine renders on demand.
+ */
+void MyApp::damagePiece(GLuint instance) {
+    mgl::Engine& engine = mgl::Engine::getInstance();
+    if (!engine.isOnDemand()) return;
+    size_t figure = instance % FigureNodes.size(), piece = instance / FigureNodes.size();
+    glm::mat4 clip = Camera.ProjectionMatrix * Camera.ViewMatrix * pieceMatrix(figure, piece);
+    glm::vec2 min(1.0f), max(-1.0f);
+    for (const glm::vec2& v : pieces[piece]->getTriangles()) {
+        glm::vec4 p = clip * glm::vec4(v, 0.0f, 1.0f);
+        min = glm::min(min, glm::vec2(p) / p.w);
+        max = glm::max(max, glm::vec2(p) / p.w);
+    }
+    int width = engine.FramebufferWidth, height = engine.FramebufferHeight;
+    int x0 = static_cast<int>(std::floor((min.x + 1.0f) * 0.5f * width)) - 1;
+    int y0 = static_cast<int>(std::floor((min.y + 1.0f) * 0.5f * height)) - 1;
+    int x1 = static_cast<int>(std::ceil((max.x + 1.0f) * 0.5f * width)) + 1;
+    int y1 = static_cast<int>(std::ceil((max.y + 1.0f) * 0.5f * height)) + 1;
+    engine.requestRedraw(x0, y0, x1 - x0, y1 - y0);
+}
 
-    // Small orange triangle
-    matrices[4] = glm::scale(I, glm::vec3(0.5f, 0.5f, 1.0f)) * matrices[4];
-    matrices[4] = glm::rotate(I, glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f))* matrices[4];
-    matrices[4] = glm::translate(I, glm::vec3(-sqrt(2) / 2 - 1.25f, 0.25f, 0.0f)) * matrices[4];
+/*
+ * Only the changed instance is uploaded, to the instance buffer and to the GPU-driven path; the other
+ * paths read it from Instances. A dragged piece that overlaps another is tinted red, a hovered one is lighter.
+ */
+void MyApp::refreshInstance(GLuint instance) {
+    size_t figure = instance % FigureNodes.size(), piece = instance / FigureNodes.size();
+    glm::vec4 color = colors[piece];
+    if (instance == Dragged && DragOverlap) color = glm::mix(color, glm::vec4(1.0f, 0.0f, 0.0f, 1.0f), 0.6f);
+    else if (instance == Hovered) color = glm::mix(color, glm::vec4(1.0f), 0.5f);
+    Instances[instance] = { pieceMatrix(figure, piece), color };
+    mgl::StateCache &state = mgl::StateCache::getInstance();
+    state.bindBuffer(GL_ARRAY_BUFFER, InstanceVBO);
+    glBufferSubData(GL_ARRAY_BUFFER, sizeof(Instance) * instance, sizeof(Instance), &Instances[instance]);
+    state.bindBuffer(GL_ARRAY_BUFFER, 0);
+    if (Indirect) {
+        GpuInstances[instance].matrix = Instances[instance].matrix;
+        GpuInstances[instance].color = color;
+        Indirect->updateInstances(&GpuInstances[instance], instance, 1);
+    }
+    damagePiece(instance);
+}
 
-    // Green square
-    matrices[5] = glm::scale(I, glm::vec3(0.5f, 0.5f, 1.0f)) * matrices[5];
-    matrices[5] = glm::translate(I, glm::vec3(-sqrt(2) / 2 - 0.75f, 0.25f, 0.0f)) * matrices[5];
+/*
+ * The piece's local translation is in the frame of its tangram group, so the world space delta is taken back
+ * through the group's world matrix. Only the piece's node, picking item and collision body are updated.
+ */
+void MyApp::dragPiece(GLuint instance, const glm::vec2& delta) {
+    damagePiece(instance);
+    size_t figure = instance % FigureNodes.size(), piece = instance / FigureNodes.size();
+    mgl::TransformNode node = Pieces[figure * PIECES + piece];
+    const glm::mat4& parent = Transforms.getWorld(Transforms.getParent(node));
+    glm::vec2 local = glm::inverse(glm::mat2(glm::vec2(parent[0]), glm::vec2(parent[1]))) * delta;
+    Transforms.setTranslation(node, Transforms.getTranslation(node) + glm::vec3(local, 0.0f));
+    Transforms.update();
+
+    Picking.setMatrix(instance, pieceMatrix(figure, piece));
+    Picking.update();
+    Collisions.setMatrix(instance, pieceMatrix(figure, piece));
+    Collisions.update();
+    DragOverlap = false;
+    for (const mgl::Contact& contact : Collisions.getContacts()) {
+        if ((contact.a == instance || contact.b == instance) && contact.depth > Collisions.Slop) DragOverlap = true;
+    }
+    refreshInstance(instance);
+}
 
-    // Orange parallelogram
-    matrices[6] = glm::scale(I, glm::vec3(0.5f, 0.5f, 1.0f)) * matrices[6];
-    matrices[6] = glm::rotate(I, glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f)) * matrices[6];
-    matrices[6] = glm::translate(I, glm::vec3(-sqrt(2) / 2 - 0.25f, 0.0f, 0.0f)) * matrices[6];
+/*
+ * A scene file replaces both the mesh pool contents and the instance buffer: the mapped file is handed
+ * straight to glBufferStorage, so nothing is parsed or copied on the CPU. The file only has what the
+ * instanced path needs, so that is the path used to draw it.
+ */
+void MyApp::loadScene() {
+    mgl::SceneFile file(Scene);
+    file.createMeshPool(*Meshes);
+    file.createInstanceBuffer(InstanceVBO);
+    Batches.assign(file.getMeshes(), file.getMeshes() + file.getMeshCount());
+    Path = RenderPath::INSTANCED;
+    std::cout << "Scene: " << Scene << " (" << file.getMeshCount() << " meshes, "
+        << file.getSection(mgl::SceneSectionType::INSTANCES).count << " instances)" << std::endl;
+}
 
-    // Universal transformations applied to the entire figure
-    for (int i = 0; i < matrices.size(); i++) {
-        matrices[i] = glm::scale(I, glm::vec3(0.5f, 0.5f, 1.0f)) * matrices[i];
-        matrices[i] = glm::rotate(I, glm::radians(-11.0f), glm::vec3(0.0f, 0.0f, 1.0f)) * matrices[i];
-        matrices[i] = glm::translate(I, glm::vec3(0.25f, 0.0f, 0.0f)) * matrices[i];
+void MyApp::saveScene() {
+    std::vector<GLubyte> vertices, indices;
+    Meshes->readBuffers(vertices, indices);
+    mgl::SceneWriter writer;
+    writer.setVertices(vertices.data(), vertices.size(), Meshes->getVertexSize());
+    writer.setIndices(indices.data(), indices.size(), Meshes->IndexType);
+    writer.setInstances(Instances.data(), static_cast<GLuint>(Instances.size()));
+    const char* names[] = { "Triangle", "Square", "Parallelogram" };
+    for (size_t i = 0; i < Batches.size(); i++) {
+        const mgl::SceneMesh &b = Batches[i];
+        writer.addMesh(names[i], Meshes->Meshes[names[i]], b.firstInstance, b.instanceCount);
     }
+    writer.write(SaveScene);
+    std::cout << "Scene saved: " << SaveScene << std::endl;
+}
+
+///////////////////////////////////////////////////////////////////////// CAMERA
+
+// Still drawing directly in clip space, so both matrices are the identity
+void MyApp::updateCamera() {
+    Camera.ViewMatrix = glm::mat4(1.0f);
+    Camera.ProjectionMatrix = glm::mat4(1.0f);
+    UniformBuffers->push(CAMERA_BINDING, &Camera, sizeof(CameraBlock));
 }
 
 ////////////////////////////////////////////////////////////////////////// SCENE
@@ -154,39 +528,309 @@ void MyApp::createTransformations() {
 void MyApp::drawScene() {
     // Drawing directly in clip space
     Shaders->bind();
-    triangle->draw(matrices[0], glm::vec4((15.0 / 255), (130.0 / 255), (242.0 / 255), 1.0f));       //Large blue triangle
-    triangle->draw(matrices[1], glm::vec4((205.0 / 255), (14.0 / 255), (102.0 / 255), 1.0f));       //Large magenta triangle
-    triangle->draw(matrices[2], glm::vec4((109.0 / 255), (59.0 / 255), (191.0 / 255), 1.0f));       //Medium purple triangle
-    triangle->draw(matrices[3], glm::vec4((0.0 / 255), (158.0 / 255), (166.0 / 255), 1.0f));        //Small teal triangle
-    triangle->draw(matrices[4], glm::vec4((235.0 / 255), (71.0 / 255), (38.0 / 255), 1.0f));        //Small orange triangle
-    square->draw(matrices[5], glm::vec4((34.0 / 255), (171.0 / 255), (36.0 / 255), 1.0f));          //Green square
-    parallelogram->draw(matrices[6], glm::vec4((253.0 / 255), (140.0 / 255), (0.0 / 255), 1.0f));   //Orange parallelogram
+    for (size_t f = 0; f < FigureNodes.size(); f++) {
+        triangle->draw(pieceMatrix(f, 0), pieceColor(f, 0));         //Large blue triangle
+        triangle->draw(pieceMatrix(f, 1), pieceColor(f, 1));         //Large magenta triangle
+        triangle->draw(pieceMatrix(f, 2), pieceColor(f, 2));         //Medium purple triangle
+        triangle->draw(pieceMatrix(f, 3), pieceColor(f, 3));         //Small teal triangle
+        triangle->draw(pieceMatrix(f, 4), pieceColor(f, 4));         //Small orange triangle
+        square->draw(pieceMatrix(f, 5), pieceColor(f, 5));           //Green square
+        parallelogram->draw(pieceMatrix(f, 6), pieceColor(f, 6));    //Orange parallelogram
+    }
     Shaders->unbind();
 }
 
+void MyApp::drawSceneInstanced() {
+    // One draw call per mesh type, regardless of the number of pieces
+    Meshes->bindInstanceBuffer(InstanceVBO, sizeof(Instance));
+    InstancedShaders->bind();
+    for (const mgl::SceneMesh &b : Batches) {
+        mgl::Mesh mesh = { b.baseVertex, b.firstIndex, static_cast<GLsizei>(b.count) };
+        Meshes->drawInstanced(mesh, static_cast<GLsizei>(b.instanceCount), b.firstInstance);
+    }
+    InstancedShaders->unbind();
+}
+
+/*
+ * Every worker records the pieces of its share of the figures as draw commands.
+ * Only submit(), on this thread, makes GL calls.
+ */
+void MyApp::drawSceneRecorded() {
+    unsigned int workers = Workers->size();
+    size_t share = (FigureNodes.size() + workers - 1) / workers;
+    Workers->run([&](unsigned int worker) {
+        mgl::CommandRecorder& recorder = Commands->getRecorder(worker);
+        size_t first = worker * share;
+        size_t last = std::min(FigureNodes.size(), first + share);
+        for (size_t f = first; f < last; f++) {
+            for (size_t i = 0; i < PIECES; i++) {
+                recorder.draw(InstancedShaders.get(), pieces[i]->getMesh(), pieceMatrix(f, i), pieceColor(f, i));
+            }
+        }
+    });
+    Commands->submit();
+}
+
+/*
+ * Pieces are pushed in the same order as drawScene(); the queue sorts them by program and mesh and
+ * draws every mesh type with a single batch.
+ */
+void MyApp::drawSceneQueued() {
+    for (size_t f = 0; f < FigureNodes.size(); f++) {
+        for (size_t i = 0; i < PIECES; i++) {
+            Queue->push({ InstancedShaders.get(), pieces[i]->getMesh(), 0, 0, 0.0f,
+                { pieceMatrix(f, i), pieceColor(f, i) } });
+        }
+    }
+    Queue->submit();
+}
+
+void MyApp::drawSceneGpu() {
+    // Culling and draw commands are produced on the GPU, the CPU cost does not grow with the board
+    Indirect->cull(*CullShaders);
+    Indirect->draw(*GpuShaders);
+}
+
 ////////////////////////////////////////////////////////////////////// CALLBACKS
 
 void MyApp::initCallback(GLFWwindow* win) {
     createShaderProgram();
     createBufferObjects();
+    createBoard();
     createTransformations();
+    if (!Scene) createInstances();
+    if (SaveScene && !Scene) saveScene();
+    if (Path == RenderPath::GPU && !Indirect) {
+        std::cerr << "[WARNING] GPU-driven path needs OpenGL 4.3 and shader draw parameters, using instanced" << std::endl;
+        Path = RenderPath::INSTANCED;
+    }
+    if (ResolutionMs > 0.0) {
+        Resolution = std::make_unique<mgl::DynamicResolution>(ResolutionMs, ResolutionFilter, UpscaleShaders.get());
+        mgl::Engine::getInstance().setDynamicResolution(Resolution.get());
+    }
+}
+
+void MyApp::setDynamicResolution(double target_ms, mgl::DynamicResolution::Filter filter) {
+    ResolutionMs = target_ms;
+    ResolutionFilter = filter;
 }
 
-void MyApp::windowCloseCallback(GLFWwindow* win) { destroyBufferObjects(); }
+void MyApp::setFixedStep(double hz) {
+    FixedStep = true;
+    mgl::Engine::getInstance().setFixedTimestep(1.0 / hz);
+}
+
+void MyApp::windowCloseCallback(GLFWwindow* win) {
+    std::cout << "Uniform uploads: " << Shaders->UniformsIssued << " issued, "
+        << Shaders->UniformsSkipped << " skipped" << std::endl;
+    mgl::StateCache &state = mgl::StateCache::getInstance();
+    std::cout << "GL state changes (last frame): " << state.LastIssued << " issued, "
+        << state.LastElided << " elided" << std::endl;
+    if (Path == RenderPath::GPU) {
+        std::cout << "GPU culling (last frame): " << Indirect->readVisibleCount() << " of "
+            << Indirect->InstanceCount << " instances visible" << std::endl;
+    }
+    if (Resolution) {
+        Resolution->report(std::cout);
+        mgl::Engine::getInstance().setDynamicResolution(nullptr);
+        Resolution.reset();
+    }
+    destroyBufferObjects();
+}
 
 void MyApp::windowSizeCallback(GLFWwindow* win, int winx, int winy) {
-    glViewport(0, 0, winx, winy);
+    mgl::StateCache::getInstance().viewport(0, 0, winx, winy);
 }
 
-void MyApp::displayCallback(GLFWwindow* win, double elapsed) { drawScene(); }
+void MyApp::keyCallback(GLFWwindow* win, int key, int scancode, int action, int mods) {
+    if (key == GLFW_KEY_P && action == GLFW_PRESS && !Scene) {
+        Path = static_cast<RenderPath>((static_cast<int>(Path) + 1) % RENDER_PATHS);
+        if (Path == RenderPath::GPU && !Indirect) Path = RenderPath::DIRECT;
+        std::cout << "Render path: " << RenderPathNames[static_cast<int>(Path)] << std::endl;
+        mgl::Engine::getInstance().requestRedraw();
+    }
+}
+
+/*
+ * The cursor is taken back to world space through the camera and looked up in the picking index,
+ * so hovering never reads anything back from the GPU. The window size is the engine's copy, as GLFW
+ * only answers on the main thread, which is not the one running callbacks with --input-thread.
+ */
+glm::vec2 MyApp::cursorToWorld(double xpos, double ypos) const {
+    mgl::Engine& engine = mgl::Engine::getInstance();
+    int width = engine.WindowWidth, height = engine.WindowHeight;
+    if (width == 0 || height == 0) return glm::vec2(0.0f);
+    glm::vec4 ndc(2.0f * xpos / width - 1.0f, 1.0f - 2.0f * ypos / height, 0.0f, 1.0f);
+    glm::vec4 world = glm::inverse(Camera.ProjectionMatrix * Camera.ViewMatrix) * ndc;
+    return glm::vec2(world) / world.w;
+}
+
+void MyApp::cursorCallback(GLFWwindow* win, double xpos, double ypos) {
+    Cursor = glm::dvec2(xpos, ypos);
+    glm::vec2 point = cursorToWorld(xpos, ypos);
+    if (Dragged != mgl::PickingIndex::NONE) {
+        if (FixedStep) {
+            DragTarget = point;
+            return;
+        }
+        dragPiece(Dragged, point - DragPoint);
+        DragPoint = point;
+        return;
+    }
+    GLuint item = Picking.pick(point);
+    if (item == Hovered) return;
+    GLuint previous = Hovered;
+    Hovered = item;
+    if (previous != mgl::PickingIndex::NONE) refreshInstance(previous);
+    if (item != mgl::PickingIndex::NONE) refreshInstance(item);
+}
+
+void MyApp::mouseButtonCallback(GLFWwindow* win, int button, int action, int mods) {
+    if (button != GLFW_MOUSE_BUTTON_LEFT) return;
+    if (action == GLFW_PRESS && Hovered != mgl::PickingIndex::NONE) {
+        DragPoint = cursorToWorld(Cursor.x, Cursor.y);
+        DragTarget = DragPrevious = DragCurrent = DragPoint;
+        Dragged = Hovered;
+    }
+    else if (action == GLFW_RELEASE && Dragged != mgl::PickingIndex::NONE) {
+        GLuint released = Dragged;
+        Dragged = mgl::PickingIndex::NONE;
+        DragOverlap = false;
+        refreshInstance(released);
+    }
+}
+
+/*
+ * With --fixed-step, a dragged piece is not moved by cursor events but eases towards the cursor here, at the
+ * same rate whatever the frame rate: every step covers a fixed fraction of the remaining distance, and the
+ * last two positions are kept for the display to interpolate between.
+ */
+void MyApp::updateCallback(GLFWwindow* win, double step) {
+    if (Dragged == mgl::PickingIndex::NONE) return;
+    const double FOLLOW_RATE = 20.0;
+    DragPrevious = DragCurrent;
+    if (glm::distance(DragCurrent, DragTarget) < 1e-4f) DragCurrent = DragTarget;
+    else DragCurrent = glm::mix(DragCurrent, DragTarget, static_cast<float>(1.0 - std::exp(-FOLLOW_RATE * step)));
+    if (DragCurrent != DragPrevious) mgl::Engine::getInstance().requestRedraw();
+}
+
+/*
+ * The dragged piece is shown where it is between the last two fixed updates. Drawing moves it, so with
+ * --partial-redraw the area it leaves is only redrawn next frame; updateCallback asks for full redraws instead.
+ */
+void MyApp::displayCallback(GLFWwindow* win, double elapsed) {
+    if (FixedStep && Dragged != mgl::PickingIndex::NONE) {
+        float alpha = static_cast<float>(mgl::Engine::getInstance().getAlpha());
+        glm::vec2 point = glm::mix(DragPrevious, DragCurrent, alpha);
+        if (point != DragPoint) dragPiece(Dragged, point - DragPoint);
+        DragPoint = point;
+    }
+
+    // Shaders compile in the background, until then the frame is only cleared and redrawn
+    bool ready = Shaders->isReady() && InstancedShaders->isReady();
+    if (Path == RenderPath::GPU) ready = ready && GpuShaders->isReady() && CullShaders->isReady();
+    if (!ready) {
+        mgl::Engine::getInstance().requestRedraw();
+        return;
+    }
+
+    UniformBuffers->beginFrame();
+    updateCamera();
+    switch (Path) {
+    case RenderPath::DIRECT: drawScene(); break;
+    case RenderPath::INSTANCED: drawSceneInstanced(); break;
+    case RenderPath::RECORDED: drawSceneRecorded(); break;
+    case RenderPath::QUEUED: drawSceneQueued(); break;
+    case RenderPath::GPU: drawSceneGpu(); break;
+    }
+    UniformBuffers->endFrame();
+}
 
 /////////////////////////////////////////////////////////////////////////// MAIN
 
 int main(int argc, char* argv[]) {
+    // --path direct|instanced|recorded|queued|gpu picks the render path, --grid N draws N x N figures
+    // --threads N sets the number of recording threads (default: one per hardware thread)
+    // --offscreen N renders N frames without a visible window, --dump PREFIX saves them as PPM
+    // --profile times every frame, --profile-dump FILE also saves the frame times as CSV or JSON
+    // --no-shader-cache always compiles shaders instead of reusing binaries from shader-cache/
+    // --scene FILE draws a binary scene file, --save-scene FILE writes the board to one
+    // --on-demand only renders when something changed, --partial-redraw also limits it to the changed area
+    // --input-thread receives events on the main thread and renders on another one
+    // --gl-debug-async N logs GL debug messages in the background, at most N per id and second (debug builds)
+    // --gl-debug-ignore ID silences a GL debug message id, may be repeated
+    // --dynamic-resolution MS scales the scene resolution to draw it in MS of GPU time,
+    // --upscale bilinear|edge picks how it is scaled back to the window
+    // --capture PATH saves the frames shown as PATHNNNNN.png, or as a video if PATH ends in .y4m,
+    // --capture-encoders N encodes them on N threads, --capture-drop skips frames when those fall behind
+    // --fixed-step HZ updates at HZ steps per second and interpolates what is displayed in between
+    RenderPath path = RenderPath::DIRECT;
+    int grid = 1;
+    unsigned int threads = 0;
+    int offscreen = -1;
+    const char* dump = nullptr;
+    bool profile = false;
+    const char* profile_dump = nullptr;
+    bool shader_cache = true;
+    const char* scene = nullptr;
+    const char* save_scene = nullptr;
+    int on_demand = 0, partial = 0, input_thread = 0, gl_debug_async = -1;
+    std::vector<GLuint> gl_debug_ignore;
+    double resolution_ms = 0.0;
+    mgl::DynamicResolution::Filter upscale = mgl::DynamicResolution::BILINEAR;
+    const char* capture = nullptr;
+    unsigned int capture_encoders = 2;
+    int capture_drop = 0;
+    double fixed_step = 0.0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--path" && i + 1 < argc) {
+            std::string name = argv[++i];
+            for (int p = 0; p < RENDER_PATHS; p++) {
+                if (name == RenderPathNames[p]) path = static_cast<RenderPath>(p);
+            }
+        }
+        else if (arg == "--grid" && i + 1 < argc) grid = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc) threads = std::atoi(argv[++i]);
+        else if (arg == "--offscreen" && i + 1 < argc) offscreen = std::atoi(argv[++i]);
+        else if (arg == "--dump" && i + 1 < argc) dump = argv[++i];
+        else if (arg == "--profile") profile = true;
+        else if (arg == "--profile-dump" && i + 1 < argc) profile_dump = argv[++i];
+        else if (arg == "--no-shader-cache") shader_cache = false;
+        else if (arg == "--scene" && i + 1 < argc) scene = argv[++i];
+        else if (arg == "--save-scene" && i + 1 < argc) save_scene = argv[++i];
+        else if (arg == "--on-demand") on_demand = 1;
+        else if (arg == "--partial-redraw") on_demand = partial = 1;
+        else if (arg == "--input-thread") input_thread = 1;
+        else if (arg == "--dynamic-resolution" && i + 1 < argc) resolution_ms = std::atof(argv[++i]);
+        else if (arg == "--upscale" && i + 1 < argc) {
+            std::string name = argv[++i];
+            upscale = name == "edge" ? mgl::DynamicResolution::EDGE_AWARE : mgl::DynamicResolution::BILINEAR;
+        }
+        else if (arg == "--capture" && i + 1 < argc) capture = argv[++i];
+        else if (arg == "--capture-encoders" && i + 1 < argc) capture_encoders = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--capture-drop") capture_drop = 1;
+        else if (arg == "--fixed-step" && i + 1 < argc) fixed_step = std::atof(argv[++i]);
+        else if (arg == "--gl-debug-async" && i + 1 < argc) gl_debug_async = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--gl-debug-ignore" && i + 1 < argc) gl_debug_ignore.push_back(std::atoi(argv[++i]));
+    }
+
+    if (shader_cache) mgl::ShaderProgram::setBinaryCache("shader-cache");
+
     mgl::Engine& engine = mgl::Engine::getInstance();
-    engine.setApp(new MyApp());
+    MyApp* app = new MyApp(path, grid, threads, scene, save_scene);
+    if (resolution_ms > 0.0) app->setDynamicResolution(resolution_ms, upscale);
+    engine.setApp(app);
+    if (fixed_step > 0.0) app->setFixedStep(fixed_step);
     engine.setOpenGL(4, 6);
     engine.setWindow(600, 600, "Hello Modern 2D World", 0, 1);
+    if (offscreen >= 0) engine.setOffscreen(offscreen, dump);
+    if (profile || profile_dump) engine.setProfiling(profile_dump);
+    if (on_demand) engine.setOnDemand(on_demand, partial);
+    if (input_thread) engine.setInputThread(input_thread);
+    if (capture) engine.setCapture(capture, capture_encoders, capture_drop);
+    if (gl_debug_async >= 0) engine.setAsyncDebugOutput(gl_debug_async);
+    if (!gl_debug_ignore.empty()) ignoreDebugMessages(gl_debug_ignore.data(), static_cast<GLsizei>(gl_debug_ignore.size()));
     engine.init();
     engine.run();
     exit(EXIT_SUCCESS);
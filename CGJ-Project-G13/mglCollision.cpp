@@ -0,0 +1,305 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Collision World Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglCollision.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+#if MGL_COLLISION_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace mgl {
+
+///////////////////////////////////////////////////////////////// CollisionWorld
+
+const GLuint CollisionWorld::MAX_VERTICES;
+
+CollisionWorld::CollisionWorld()
+    : Slop(1e-4f), BroadphasePairs(0), PairsTested(0), ShapeFirst{0} {}
+
+static GLfloat cross(const glm::vec2 &o, const glm::vec2 &a,
+                     const glm::vec2 &b) {
+  return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+// Convex hull by monotone chain, counterclockwise, without collinear points
+GLuint CollisionWorld::addShape(const glm::vec2 *points, const GLuint count) {
+  std::vector<glm::vec2> sorted(points, points + count);
+  std::sort(sorted.begin(), sorted.end(),
+            [](const glm::vec2 &a, const glm::vec2 &b) {
+              return a.x < b.x || (a.x == b.x && a.y < b.y);
+            });
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+  std::vector<glm::vec2> hull(2 * sorted.size());
+  size_t k = 0;
+  if (sorted.size() >= 3) {
+    for (size_t i = 0; i < sorted.size(); i++) {
+      while (k >= 2 && cross(hull[k - 2], hull[k - 1], sorted[i]) <= 0.0f)
+        k--;
+      hull[k++] = sorted[i];
+    }
+    for (size_t i = sorted.size() - 1, lower = k + 1; i-- > 0;) {
+      while (k >= lower && cross(hull[k - 2], hull[k - 1], sorted[i]) <= 0.0f)
+        k--;
+      hull[k++] = sorted[i];
+    }
+    k--;
+  }
+  hull.resize(k);
+  if (hull.size() < 3 || hull.size() > MAX_VERTICES) {
+    std::cerr << "[ERROR] Collision shape hull has " << hull.size()
+              << " vertices, must have 3 to " << MAX_VERTICES << std::endl;
+    throw std::runtime_error("Invalid collision shape.");
+  }
+  ShapeVertices.insert(ShapeVertices.end(), hull.begin(), hull.end());
+  ShapeFirst.push_back(static_cast<GLuint>(ShapeVertices.size()));
+  return static_cast<GLuint>(ShapeFirst.size() - 2);
+}
+
+GLuint CollisionWorld::addBody(const GLuint shape, const glm::mat4 &matrix) {
+  if (shape + 1 >= ShapeFirst.size()) {
+    std::cerr << "[ERROR] Unknown collision shape: " << shape << std::endl;
+    throw std::runtime_error("Unknown collision shape.");
+  }
+  const GLuint body = static_cast<GLuint>(Shapes.size());
+  Shapes.push_back(shape);
+  Matrices.push_back(matrix);
+  Polygons.push_back({});
+  Dirty.push_back(1);
+  Sorted.push_back({0.0f, 0.0f, 0.0f, 0.0f, body});
+  return body;
+}
+
+void CollisionWorld::setMatrix(const GLuint body, const glm::mat4 &matrix) {
+  Matrices[body] = matrix;
+  Dirty[body] = 1;
+}
+
+GLuint CollisionWorld::size() const {
+  return static_cast<GLuint>(Shapes.size());
+}
+
+void CollisionWorld::clear() {
+  ShapeVertices.clear();
+  ShapeFirst.assign(1, 0);
+  Shapes.clear();
+  Matrices.clear();
+  Polygons.clear();
+  Dirty.clear();
+  Sorted.clear();
+  Pairs.clear();
+  Contacts.clear();
+}
+
+const std::vector<Contact> &CollisionWorld::getContacts() const {
+  return Contacts;
+}
+
+//////////////////////////////////////////////////////////////////// UPDATING
+
+// Unused lanes repeat the last vertex and normal, which changes neither the
+// projections nor the result of the tests.
+void CollisionWorld::transform(const GLuint body) {
+  Polygon &p = Polygons[body];
+  const glm::mat4 &m = Matrices[body];
+  const GLuint first = ShapeFirst[Shapes[body]];
+  p.count = ShapeFirst[Shapes[body] + 1] - first;
+  p.min = glm::vec2(std::numeric_limits<GLfloat>::max());
+  p.max = -p.min;
+  for (GLuint k = 0; k < p.count; k++) {
+    const glm::vec2 &l = ShapeVertices[first + k];
+    const glm::vec2 w =
+        glm::vec2(m[0]) * l.x + glm::vec2(m[1]) * l.y + glm::vec2(m[3]);
+    p.x[k] = w.x;
+    p.y[k] = w.y;
+    p.min = glm::min(p.min, w);
+    p.max = glm::max(p.max, w);
+  }
+  for (GLuint k = 0; k < p.count; k++) {
+    const GLuint next = (k + 1) % p.count;
+    const glm::vec2 edge(p.x[next] - p.x[k], p.y[next] - p.y[k]);
+    const GLfloat length = glm::length(edge);
+    const glm::vec2 n =
+        length > 0.0f ? glm::vec2(edge.y, -edge.x) / length : glm::vec2(1, 0);
+    p.nx[k] = n.x;
+    p.ny[k] = n.y;
+  }
+  for (GLuint k = p.count; k < MAX_VERTICES; k++) {
+    p.x[k] = p.x[p.count - 1];
+    p.y[k] = p.y[p.count - 1];
+    p.nx[k] = p.nx[p.count - 1];
+    p.ny[k] = p.ny[p.count - 1];
+  }
+  Dirty[body] = 0;
+}
+
+// The sorted boxes are copied to one array per coordinate, padded with boxes
+// at infinity: a run of candidates stops at the first group of four with no
+// box left in range, which is at most seven boxes past the end.
+void CollisionWorld::sweep() {
+  for (Box &box : Sorted) {
+    const Polygon &p = Polygons[box.body];
+    box = {p.min.x, p.max.x, p.min.y, p.max.y, box.body};
+  }
+  for (size_t i = 1; i < Sorted.size(); i++) {
+    const Box box = Sorted[i];
+    size_t j = i;
+    for (; j > 0 && Sorted[j - 1].minX > box.minX; j--)
+      Sorted[j] = Sorted[j - 1];
+    Sorted[j] = box;
+  }
+  const size_t count = Sorted.size();
+  const GLfloat infinity = std::numeric_limits<GLfloat>::infinity();
+  SweepMinX.assign(count + 8, infinity);
+  SweepMaxX.assign(count + 8, infinity);
+  SweepMinY.assign(count + 8, infinity);
+  SweepMaxY.assign(count + 8, infinity);
+  for (size_t i = 0; i < count; i++) {
+    SweepMinX[i] = Sorted[i].minX;
+    SweepMaxX[i] = Sorted[i].maxX;
+    SweepMinY[i] = Sorted[i].minY;
+    SweepMaxY[i] = Sorted[i].maxY;
+  }
+
+  Pairs.clear();
+  for (size_t i = 0; i < count; i++) {
+    const GLfloat right = SweepMaxX[i] + Slop;
+    const GLfloat bottom = SweepMinY[i] - Slop, top = SweepMaxY[i] + Slop;
+#if MGL_COLLISION_SSE2
+    const __m128 right4 = _mm_set1_ps(right);
+    const __m128 bottom4 = _mm_set1_ps(bottom), top4 = _mm_set1_ps(top);
+    for (size_t j = i + 1;; j += 4) {
+      const __m128 in_x = _mm_cmple_ps(_mm_loadu_ps(&SweepMinX[j]), right4);
+      if (_mm_movemask_ps(in_x) == 0)
+        break;
+      const __m128 in_y =
+          _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&SweepMinY[j]), top4),
+                     _mm_cmpge_ps(_mm_loadu_ps(&SweepMaxY[j]), bottom4));
+      const int hits = _mm_movemask_ps(_mm_and_ps(in_x, in_y));
+      for (int lane = 0; hits != 0 && lane < 4; lane++) {
+        if (hits & (1 << lane))
+          Pairs.push_back(std::minmax(Sorted[i].body, Sorted[j + lane].body));
+      }
+    }
+#else
+    for (size_t j = i + 1; SweepMinX[j] <= right; j++) {
+      if (SweepMinY[j] <= top && SweepMaxY[j] >= bottom)
+        Pairs.push_back(std::minmax(Sorted[i].body, Sorted[j].body));
+    }
+#endif
+  }
+}
+
+void CollisionWorld::update() {
+  for (GLuint body = 0; body < Dirty.size(); body++) {
+    if (Dirty[body])
+      transform(body);
+  }
+  sweep();
+  BroadphasePairs = static_cast<GLuint>(Pairs.size());
+  PairsTested = 0;
+  Contacts.clear();
+  Contact contact;
+  for (const std::pair<GLuint, GLuint> &pair : Pairs) {
+    PairsTested++;
+    if (test(pair.first, pair.second, contact))
+      Contacts.push_back(contact);
+  }
+}
+
+///////////////////////////////////////////////////////////////// NARROWPHASE
+
+// Separating axis test over the edge normals of both polygons, four axes at a
+// time: every vertex is projected on the four axes at once, so no horizontal
+// reductions are needed.
+bool CollisionWorld::test(const GLuint a, const GLuint b,
+                          Contact &contact) const {
+  const Polygon &pa = Polygons[a];
+  const Polygon &pb = Polygons[b];
+  GLfloat ax[2 * MAX_VERTICES + 3], ay[2 * MAX_VERTICES + 3];
+  std::copy(pa.nx, pa.nx + pa.count, ax);
+  std::copy(pa.ny, pa.ny + pa.count, ay);
+  std::copy(pb.nx, pb.nx + pb.count, ax + pa.count);
+  std::copy(pb.ny, pb.ny + pb.count, ay + pa.count);
+  const GLuint axes = pa.count + pb.count;
+  for (GLuint k = axes; k % 4 != 0; k++) {
+    ax[k] = ax[axes - 1];
+    ay[k] = ay[axes - 1];
+  }
+
+  GLfloat best = std::numeric_limits<GLfloat>::max();
+  GLuint best_axis = 0;
+  for (GLuint k = 0; k < axes; k += 4) {
+    GLfloat overlap[4];
+#if MGL_COLLISION_SSE2
+    const __m128 nx = _mm_loadu_ps(ax + k);
+    const __m128 ny = _mm_loadu_ps(ay + k);
+    __m128 min_a = _mm_set1_ps(std::numeric_limits<GLfloat>::max());
+    __m128 max_a = _mm_set1_ps(-std::numeric_limits<GLfloat>::max());
+    __m128 min_b = min_a, max_b = max_a;
+    for (GLuint v = 0; v < pa.count; v++) {
+      const __m128 d = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(pa.x[v]), nx),
+                                  _mm_mul_ps(_mm_set1_ps(pa.y[v]), ny));
+      min_a = _mm_min_ps(min_a, d);
+      max_a = _mm_max_ps(max_a, d);
+    }
+    for (GLuint v = 0; v < pb.count; v++) {
+      const __m128 d = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(pb.x[v]), nx),
+                                  _mm_mul_ps(_mm_set1_ps(pb.y[v]), ny));
+      min_b = _mm_min_ps(min_b, d);
+      max_b = _mm_max_ps(max_b, d);
+    }
+    _mm_storeu_ps(overlap, _mm_sub_ps(_mm_min_ps(max_a, max_b),
+                                      _mm_max_ps(min_a, min_b)));
+#else
+    for (GLuint lane = 0; lane < 4; lane++) {
+      GLfloat min_a = std::numeric_limits<GLfloat>::max(), max_a = -min_a;
+      GLfloat min_b = min_a, max_b = max_a;
+      for (GLuint v = 0; v < pa.count; v++) {
+        const GLfloat d = pa.x[v] * ax[k + lane] + pa.y[v] * ay[k + lane];
+        min_a = std::min(min_a, d);
+        max_a = std::max(max_a, d);
+      }
+      for (GLuint v = 0; v < pb.count; v++) {
+        const GLfloat d = pb.x[v] * ax[k + lane] + pb.y[v] * ay[k + lane];
+        min_b = std::min(min_b, d);
+        max_b = std::max(max_b, d);
+      }
+      overlap[lane] = std::min(max_a, max_b) - std::max(min_a, min_b);
+    }
+#endif
+    for (GLuint lane = 0; lane < 4; lane++) {
+      if (overlap[lane] < best) {
+        best = overlap[lane];
+        best_axis = k + lane;
+      }
+    }
+    if (best < -Slop)
+      return false;
+  }
+
+  glm::vec2 normal(ax[best_axis], ay[best_axis]);
+  const glm::vec2 between = (pb.min + pb.max - pa.min - pa.max) * 0.5f;
+  if (glm::dot(between, normal) < 0.0f)
+    normal = -normal;
+  GLuint deepest = 0;
+  for (GLuint v = 1; v < pb.count; v++) {
+    if (pb.x[v] * normal.x + pb.y[v] * normal.y <
+        pb.x[deepest] * normal.x + pb.y[deepest] * normal.y)
+      deepest = v;
+  }
+  contact = {a, b, normal, best, glm::vec2(pb.x[deepest], pb.y[deepest])};
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
@@ -0,0 +1,194 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Mesh Pool Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglMesh.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include "./mglState.hpp"
+
+namespace mgl {
+
+/////////////////////////////////////////////////////////////////////// MeshPool
+
+MeshPool::MeshPool(const VertexLayout &vertex_layout,
+                   const VertexLayout &instance_layout)
+    : VaoId(0), BufferIds{0, 0}, IndexType(GL_UNSIGNED_BYTE),
+      VertexAttributes(vertex_layout), InstanceAttributes(instance_layout),
+      VertexSize(vertex_layout.Stride), VertexCount(0), IndexSize(1),
+      MaxIndex(0) {}
+
+MeshPool::~MeshPool() {
+  StateCache &state = StateCache::getInstance();
+  state.forgetVertexArray(VaoId);
+  state.forgetBuffer(BufferIds[0]);
+  state.forgetBuffer(BufferIds[1]);
+  glDeleteVertexArrays(1, &VaoId);
+  glDeleteBuffers(2, BufferIds);
+}
+
+const Mesh &MeshPool::addMesh(const std::string &name, const void *vertices,
+                              const GLsizei vertex_count,
+                              const GLuint *indices,
+                              const GLsizei index_count) {
+  if (VaoId != 0) {
+    throw std::runtime_error("Mesh added after MeshPool::create().");
+  }
+  if (isMesh(name)) {
+    std::cerr << "[WARNING] Mesh " << name << " already exists" << std::endl;
+  }
+  const GLubyte *bytes = static_cast<const GLubyte *>(vertices);
+  VertexData.insert(VertexData.end(), bytes,
+                    bytes + vertex_count * VertexSize);
+  Meshes[name] = {VertexCount, static_cast<GLuint>(IndexData.size()),
+                  index_count};
+  IndexData.insert(IndexData.end(), indices, indices + index_count);
+  for (GLsizei i = 0; i < index_count; i++)
+    MaxIndex = std::max(MaxIndex, indices[i]);
+  VertexCount += vertex_count;
+  return Meshes[name];
+}
+
+const Mesh &MeshPool::addMesh(const std::string &name, const void *vertices,
+                              const GLsizei vertex_count,
+                              const GLubyte *indices,
+                              const GLsizei index_count) {
+  const std::vector<GLuint> wide(indices, indices + index_count);
+  return addMesh(name, vertices, vertex_count, wide.data(), index_count);
+}
+
+bool MeshPool::isMesh(const std::string &name) {
+  return Meshes.find(name) != Meshes.end();
+}
+
+void MeshPool::create() {
+  if (MaxIndex > 0xFFFF) {
+    IndexType = GL_UNSIGNED_INT;
+  } else if (MaxIndex > 0xFF) {
+    IndexType = GL_UNSIGNED_SHORT;
+  }
+  const GLuint index_size = getIndexSize(IndexType);
+  std::vector<GLubyte> indices(IndexData.size() * index_size);
+  for (size_t i = 0; i < IndexData.size(); i++) {
+    if (index_size == sizeof(GLuint))
+      reinterpret_cast<GLuint *>(indices.data())[i] = IndexData[i];
+    else if (index_size == sizeof(GLushort))
+      reinterpret_cast<GLushort *>(indices.data())[i] =
+          static_cast<GLushort>(IndexData[i]);
+    else
+      indices[i] = static_cast<GLubyte>(IndexData[i]);
+  }
+  create(VertexData.data(), VertexData.size(), indices.data(), indices.size(),
+         IndexType);
+
+  // The GPU copy is the only one needed from now on
+  std::vector<GLubyte>().swap(VertexData);
+  std::vector<GLuint>().swap(IndexData);
+}
+
+// Buffers are immutable and filled straight from the given memory, which may
+// be a mapped file; meshes must have been registered in Meshes beforehand.
+void MeshPool::create(const void *vertices, const GLsizeiptr vertices_size,
+                      const void *indices, const GLsizeiptr indices_size,
+                      const GLenum index_type) {
+  if (VaoId != 0) {
+    throw std::runtime_error("MeshPool::create() called twice.");
+  }
+  IndexType = index_type;
+  IndexSize = getIndexSize(index_type);
+
+  StateCache &state = StateCache::getInstance();
+  glGenVertexArrays(1, &VaoId);
+  state.bindVertexArray(VaoId);
+  glGenBuffers(2, BufferIds);
+
+  state.bindBuffer(GL_ARRAY_BUFFER, BufferIds[0]);
+  glBufferStorage(GL_ARRAY_BUFFER, vertices_size, vertices, 0);
+  state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, BufferIds[1]);
+  glBufferStorage(GL_ELEMENT_ARRAY_BUFFER, indices_size, indices, 0);
+
+  VertexAttributes.configure(VERTEX_BINDING);
+  InstanceAttributes.configure(INSTANCE_BINDING);
+  glBindVertexBuffer(VERTEX_BINDING, BufferIds[0], 0, VertexSize);
+  glVertexBindingDivisor(INSTANCE_BINDING, 1);
+
+  // The element array buffer stays bound to the VAO
+  state.bindVertexArray(0);
+  state.bindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Copies the GPU buffers back, e.g. to save them to a file
+void MeshPool::readBuffers(std::vector<GLubyte> &vertices,
+                           std::vector<GLubyte> &indices) const {
+  StateCache &state = StateCache::getInstance();
+  GLint size = 0;
+  state.bindBuffer(GL_COPY_READ_BUFFER, BufferIds[0]);
+  glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+  vertices.resize(size);
+  glGetBufferSubData(GL_COPY_READ_BUFFER, 0, size, vertices.data());
+  state.bindBuffer(GL_COPY_READ_BUFFER, BufferIds[1]);
+  glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+  indices.resize(size);
+  glGetBufferSubData(GL_COPY_READ_BUFFER, 0, size, indices.data());
+  state.bindBuffer(GL_COPY_READ_BUFFER, 0);
+}
+
+GLsizei MeshPool::getVertexSize() const { return VertexSize; }
+
+GLuint MeshPool::getIndexSize(const GLenum index_type) {
+  switch (index_type) {
+  case GL_UNSIGNED_BYTE:
+    return sizeof(GLubyte);
+  case GL_UNSIGNED_SHORT:
+    return sizeof(GLushort);
+  case GL_UNSIGNED_INT:
+    return sizeof(GLuint);
+  default:
+    throw std::runtime_error("Unsupported index type.");
+  }
+}
+
+void MeshPool::bind() { StateCache::getInstance().bindVertexArray(VaoId); }
+
+void MeshPool::unbind() { StateCache::getInstance().bindVertexArray(0); }
+
+void MeshPool::bindInstanceBuffer(const GLuint buffer_id,
+                                  const GLsizei stride) {
+  bind();
+  glBindVertexBuffer(INSTANCE_BINDING, buffer_id, 0, stride);
+  unbind();
+}
+
+GLvoid *MeshPool::indexOffset(const Mesh &mesh) const {
+  return reinterpret_cast<GLvoid *>(
+      static_cast<GLintptr>(mesh.firstIndex) * IndexSize);
+}
+
+void MeshPool::draw(const Mesh &mesh) {
+  glDrawElementsBaseVertex(GL_TRIANGLES, mesh.count, IndexType,
+                           indexOffset(mesh), mesh.baseVertex);
+}
+
+void MeshPool::drawInstanced(const Mesh &mesh, const GLsizei instance_count,
+                             const GLuint base_instance) {
+  glDrawElementsInstancedBaseVertexBaseInstance(
+      GL_TRIANGLES, mesh.count, IndexType, indexOffset(mesh), instance_count,
+      mesh.baseVertex, base_instance);
+}
+
+// The commands are read from the bound GL_DRAW_INDIRECT_BUFFER
+void MeshPool::drawIndirect(const GLintptr offset, const GLsizei draw_count) {
+  glMultiDrawElementsIndirect(GL_TRIANGLES, IndexType,
+                              reinterpret_cast<const GLvoid *>(offset),
+                              draw_count, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
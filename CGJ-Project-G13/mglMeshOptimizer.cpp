@@ -0,0 +1,256 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Mesh Optimizer Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglMeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace mgl {
+
+static const GLuint NONE = 0xFFFFFFFF;
+
+////////////////////////////////////////////////////////////////// MeshOptimizer
+
+const GLuint MeshOptimizer::CACHE_SIZE;
+
+MeshOptimizer::MeshOptimizer(const void *vertices, const GLsizei vertex_count,
+                             const GLsizei vertex_size, const GLuint *indices,
+                             const GLsizei index_count)
+    : Indices(indices, indices + index_count), VertexSize(vertex_size),
+      OriginalVertices(vertex_count) {
+  if (index_count % 3 != 0) {
+    throw std::runtime_error("Mesh index count is not a multiple of 3.");
+  }
+  const GLubyte *bytes = static_cast<const GLubyte *>(vertices);
+  Vertices.assign(bytes, bytes + vertex_count * vertex_size);
+  OriginalACMR = getACMR();
+}
+
+MeshOptimizer::MeshOptimizer(const void *vertices, const GLsizei vertex_count,
+                             const GLsizei vertex_size, const GLubyte *indices,
+                             const GLsizei index_count)
+    : MeshOptimizer(vertices, vertex_count, vertex_size,
+                    std::vector<GLuint>(indices, indices + index_count).data(),
+                    index_count) {}
+
+GLsizei MeshOptimizer::getVertexCount() const {
+  return static_cast<GLsizei>(Vertices.size() / VertexSize);
+}
+
+GLsizei MeshOptimizer::getIndexCount() const {
+  return static_cast<GLsizei>(Indices.size());
+}
+
+float MeshOptimizer::getACMR(const GLuint cache_size) const {
+  if (Indices.empty())
+    return 0.0f;
+  std::vector<GLuint> fifo(cache_size, NONE);
+  size_t head = 0;
+  size_t misses = 0;
+  for (GLuint index : Indices) {
+    if (std::find(fifo.begin(), fifo.end(), index) != fifo.end())
+      continue;
+    fifo[head] = index;
+    head = (head + 1) % cache_size;
+    misses++;
+  }
+  return static_cast<float>(misses) / (Indices.size() / 3);
+}
+
+// Moves vertex i to remap[i], or drops it if remap[i] is NONE
+void MeshOptimizer::remap(const std::vector<GLuint> &remap,
+                          const GLuint vertex_count) {
+  std::vector<GLubyte> vertices(vertex_count * VertexSize);
+  for (size_t i = 0; i < remap.size(); i++) {
+    if (remap[i] != NONE)
+      std::memcpy(&vertices[remap[i] * VertexSize], &Vertices[i * VertexSize],
+                  VertexSize);
+  }
+  Vertices.swap(vertices);
+  for (GLuint &index : Indices)
+    index = remap[index];
+}
+
+////////////////////////////////////////////////////////////////////////// WELD
+
+static GLuint hashVertex(const GLubyte *vertex, const GLsizei size) {
+  GLuint hash = 2166136261u; // FNV-1a
+  for (GLsizei i = 0; i < size; i++)
+    hash = (hash ^ vertex[i]) * 16777619u;
+  return hash;
+}
+
+// Open addressing, with a table at least twice the vertex count. Duplicates
+// are copied over their first occurrence, which holds the same bytes.
+void MeshOptimizer::weld() {
+  const GLuint count = getVertexCount();
+  GLuint capacity = 1;
+  while (capacity < count * 2)
+    capacity *= 2;
+  std::vector<GLuint> table(capacity, NONE);
+  std::vector<GLuint> welded(count);
+  GLuint unique = 0;
+  for (GLuint i = 0; i < count; i++) {
+    const GLubyte *vertex = &Vertices[i * VertexSize];
+    GLuint slot = hashVertex(vertex, VertexSize) & (capacity - 1);
+    while (table[slot] != NONE &&
+           std::memcmp(&Vertices[table[slot] * VertexSize], vertex,
+                       VertexSize) != 0)
+      slot = (slot + 1) & (capacity - 1);
+    if (table[slot] == NONE) {
+      table[slot] = i;
+      welded[i] = unique++;
+    } else {
+      welded[i] = welded[table[slot]];
+    }
+  }
+  remap(welded, unique);
+}
+
+/////////////////////////////////////////////////////////////////// VERTEX FETCH
+
+void MeshOptimizer::optimizeVertexFetch() {
+  std::vector<GLuint> order(getVertexCount(), NONE);
+  GLuint next = 0;
+  for (GLuint index : Indices) {
+    if (order[index] == NONE)
+      order[index] = next++;
+  }
+  remap(order, next);
+}
+
+/////////////////////////////////////////////////////////////////// VERTEX CACHE
+
+// Scores from the paper: the three most recent vertices score the same, so
+// whole triangles are preferred, and vertices with few remaining triangles
+// are boosted, so they are finished off instead of left behind.
+static const GLuint LRU_SIZE = 32;
+
+static float vertexScore(const GLuint cache_position, const GLuint remaining) {
+  if (remaining == 0)
+    return -1.0f;
+  float score = 0.0f;
+  if (cache_position < 3) {
+    score = 0.75f;
+  } else if (cache_position < LRU_SIZE) {
+    const float scale = 1.0f / (LRU_SIZE - 3);
+    score = std::pow(1.0f - (cache_position - 3) * scale, 1.5f);
+  }
+  return score + 2.0f / std::sqrt(static_cast<float>(remaining));
+}
+
+void MeshOptimizer::optimizeVertexCache() {
+  const GLuint vertex_count = getVertexCount();
+  const GLuint triangle_count = static_cast<GLuint>(Indices.size() / 3);
+
+  // Triangles of each vertex, as offsets into one array
+  std::vector<GLuint> remaining(vertex_count, 0);
+  for (GLuint index : Indices)
+    remaining[index]++;
+  std::vector<GLuint> first(vertex_count + 1, 0);
+  for (GLuint v = 0; v < vertex_count; v++)
+    first[v + 1] = first[v] + remaining[v];
+  std::vector<GLuint> adjacency(Indices.size());
+  std::vector<GLuint> filled(first.begin(), first.end() - 1);
+  for (GLuint t = 0; t < triangle_count; t++) {
+    for (GLuint k = 0; k < 3; k++)
+      adjacency[filled[Indices[t * 3 + k]]++] = t;
+  }
+
+  std::vector<float> vertex_score(vertex_count);
+  for (GLuint v = 0; v < vertex_count; v++)
+    vertex_score[v] = vertexScore(NONE, remaining[v]);
+  std::vector<float> triangle_score(triangle_count);
+  std::vector<bool> emitted(triangle_count, false);
+  for (GLuint t = 0; t < triangle_count; t++) {
+    triangle_score[t] = vertex_score[Indices[t * 3]] +
+                        vertex_score[Indices[t * 3 + 1]] +
+                        vertex_score[Indices[t * 3 + 2]];
+  }
+
+  std::vector<GLuint> cache;
+  std::vector<GLuint> next_cache;
+  std::vector<GLuint> output;
+  output.reserve(Indices.size());
+  GLuint cursor = 0; // first triangle that may not have been emitted
+  GLuint best = NONE;
+  while (output.size() < Indices.size()) {
+    if (best == NONE) {
+      // Nothing in the cache is usable, continue with the next unused
+      // triangle in input order, which keeps this linear
+      while (emitted[cursor])
+        cursor++;
+      best = cursor;
+    }
+    emitted[best] = true;
+    next_cache.clear();
+    for (GLuint k = 0; k < 3; k++) {
+      const GLuint v = Indices[best * 3 + k];
+      output.push_back(v);
+      next_cache.push_back(v);
+      // Remove the triangle from the vertex's list of remaining ones, whose
+      // order does not matter, by swapping it with the last one
+      GLuint *list = &adjacency[first[v]];
+      std::swap(*std::find(list, list + remaining[v], best),
+                list[remaining[v] - 1]);
+      remaining[v]--;
+    }
+    for (GLuint v : cache) {
+      if (std::find(next_cache.begin(), next_cache.end(), v) ==
+          next_cache.end())
+        next_cache.push_back(v);
+    }
+    for (size_t i = LRU_SIZE; i < next_cache.size(); i++) {
+      const GLuint evicted = next_cache[i];
+      vertex_score[evicted] = vertexScore(NONE, remaining[evicted]);
+    }
+    if (next_cache.size() > LRU_SIZE)
+      next_cache.resize(LRU_SIZE);
+    cache.swap(next_cache);
+
+    // Rescore the cached vertices and their triangles, keeping the best one
+    for (GLuint i = 0; i < cache.size(); i++)
+      vertex_score[cache[i]] = vertexScore(i, remaining[cache[i]]);
+    best = NONE;
+    float best_score = -1.0f;
+    for (GLuint v : cache) {
+      for (GLuint a = first[v]; a < first[v] + remaining[v]; a++) {
+        const GLuint t = adjacency[a];
+        triangle_score[t] = vertex_score[Indices[t * 3]] +
+                            vertex_score[Indices[t * 3 + 1]] +
+                            vertex_score[Indices[t * 3 + 2]];
+        if (triangle_score[t] > best_score) {
+          best_score = triangle_score[t];
+          best = t;
+        }
+      }
+    }
+  }
+  Indices.swap(output);
+}
+
+/////////////////////////////////////////////////////////////////////// OPTIMIZE
+
+void MeshOptimizer::optimize() {
+  weld();
+  optimizeVertexCache();
+  optimizeVertexFetch();
+}
+
+void MeshOptimizer::report(std::ostream &os, const std::string &name) const {
+  os << "Mesh " << name << ": " << OriginalVertices << " -> "
+     << getVertexCount() << " vertices, ACMR " << OriginalACMR << " -> "
+     << getACMR() << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
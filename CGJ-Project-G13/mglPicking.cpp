@@ -0,0 +1,311 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Picking Index Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglPicking.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+#if MGL_PICKING_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace mgl {
+
+/////////////////////////////////////////////////////////////////// PickingIndex
+
+const GLuint PickingIndex::NONE;
+const GLuint PickingIndex::LEAF_SIZE;
+
+PickingIndex::PickingIndex() : Refitted(0), ShapeFirst{0}, Built(false) {}
+
+GLuint PickingIndex::addShape(const glm::vec2 *vertices,
+                              const GLuint vertex_count) {
+  if (vertex_count % 3 != 0) {
+    std::cerr << "[ERROR] Picking shape is not a triangle list: "
+              << vertex_count << " vertices" << std::endl;
+    throw std::runtime_error("Picking shape is not a triangle list.");
+  }
+  ShapeVertices.insert(ShapeVertices.end(), vertices, vertices + vertex_count);
+  ShapeFirst.push_back(static_cast<GLuint>(ShapeVertices.size()));
+  return static_cast<GLuint>(ShapeFirst.size() - 2);
+}
+
+GLuint PickingIndex::addItem(const GLuint shape, const glm::mat4 &matrix) {
+  if (shape + 1 >= ShapeFirst.size()) {
+    std::cerr << "[ERROR] Unknown picking shape: " << shape << std::endl;
+    throw std::runtime_error("Unknown picking shape.");
+  }
+  Items.push_back({shape, NONE, NONE, false, glm::vec2(0.0f), glm::vec2(0.0f)});
+  Matrices.push_back(matrix);
+  Built = false;
+  return static_cast<GLuint>(Items.size() - 1);
+}
+
+void PickingIndex::setMatrix(const GLuint item, const glm::mat4 &matrix) {
+  Matrices[item] = matrix;
+  if (!Items[item].dirty) {
+    Items[item].dirty = true;
+    Dirty.push_back(item);
+  }
+}
+
+GLuint PickingIndex::size() const { return static_cast<GLuint>(Items.size()); }
+
+void PickingIndex::clear() {
+  ShapeVertices.clear();
+  ShapeFirst.assign(1, 0);
+  Items.clear();
+  Matrices.clear();
+  Dirty.clear();
+  Order.clear();
+  Nodes.clear();
+  Blocks.clear();
+  Built = false;
+}
+
+///////////////////////////////////////////////////////////////////// BUILDING
+
+// Transforms the triangles of an item, updating its bounds and, once it has a
+// place in a leaf, its lanes of the leaf's blocks.
+void PickingIndex::writeItem(const GLuint item) {
+  Item &it = Items[item];
+  const glm::mat4 &m = Matrices[item];
+  it.min = glm::vec2(std::numeric_limits<GLfloat>::max());
+  it.max = -it.min;
+  GLuint slot = it.slot;
+  for (GLuint v = ShapeFirst[it.shape]; v < ShapeFirst[it.shape + 1]; v += 3) {
+    glm::vec2 p[3];
+    for (GLuint k = 0; k < 3; k++) {
+      const glm::vec2 &l = ShapeVertices[v + k];
+      p[k] = glm::vec2(m[0]) * l.x + glm::vec2(m[1]) * l.y + glm::vec2(m[3]);
+      it.min = glm::min(it.min, p[k]);
+      it.max = glm::max(it.max, p[k]);
+    }
+    if (slot == NONE)
+      continue;
+    Block &b = Blocks[slot / 4];
+    const GLuint lane = slot % 4;
+    b.x0[lane] = p[0].x;
+    b.y0[lane] = p[0].y;
+    b.x1[lane] = p[1].x;
+    b.y1[lane] = p[1].y;
+    b.x2[lane] = p[2].x;
+    b.y2[lane] = p[2].y;
+    b.item[lane] = item;
+    slot++;
+  }
+}
+
+// Median split of the items' box centers along the longest axis of their
+// bounds. Nodes are stored depth first, so a left child follows its parent.
+GLuint PickingIndex::buildNode(const GLuint parent, const GLuint first,
+                               const GLuint count) {
+  const GLuint index = static_cast<GLuint>(Nodes.size());
+  Node node = {glm::vec2(std::numeric_limits<GLfloat>::max()),
+               glm::vec2(-std::numeric_limits<GLfloat>::max()),
+               parent,
+               0,
+               first,
+               count,
+               0,
+               0};
+  for (GLuint i = first; i < first + count; i++) {
+    node.min = glm::min(node.min, Items[Order[i]].min);
+    node.max = glm::max(node.max, Items[Order[i]].max);
+  }
+  Nodes.push_back(node);
+
+  if (count <= LEAF_SIZE) {
+    GLuint triangles = 0;
+    for (GLuint i = first; i < first + count; i++) {
+      const Item &it = Items[Order[i]];
+      triangles += (ShapeFirst[it.shape + 1] - ShapeFirst[it.shape]) / 3;
+    }
+    const GLfloat nan = std::numeric_limits<GLfloat>::quiet_NaN();
+    Block empty; // NaN lanes never contain a point
+    for (GLuint lane = 0; lane < 4; lane++) {
+      empty.x0[lane] = empty.y0[lane] = empty.x1[lane] = nan;
+      empty.y1[lane] = empty.x2[lane] = empty.y2[lane] = nan;
+      empty.item[lane] = NONE;
+    }
+    Nodes[index].firstBlock = static_cast<GLuint>(Blocks.size());
+    Nodes[index].blockCount = (triangles + 3) / 4;
+    GLuint slot = Nodes[index].firstBlock * 4;
+    Blocks.resize(Blocks.size() + Nodes[index].blockCount, empty);
+    for (GLuint i = first; i < first + count; i++) {
+      Item &it = Items[Order[i]];
+      it.leaf = index;
+      it.slot = slot;
+      slot += (ShapeFirst[it.shape + 1] - ShapeFirst[it.shape]) / 3;
+      writeItem(Order[i]);
+    }
+    return index;
+  }
+
+  const glm::vec2 extent = node.max - node.min;
+  const int axis = extent.x >= extent.y ? 0 : 1;
+  const GLuint half = count / 2;
+  std::nth_element(Order.begin() + first, Order.begin() + first + half,
+                   Order.begin() + first + count,
+                   [&](const GLuint a, const GLuint b) {
+                     return Items[a].min[axis] + Items[a].max[axis] <
+                            Items[b].min[axis] + Items[b].max[axis];
+                   });
+  buildNode(index, first, half);
+  const GLuint right = buildNode(index, first + half, count - half);
+  Nodes[index].right = right;
+  return index;
+}
+
+void PickingIndex::build() {
+  Nodes.clear();
+  Blocks.clear();
+  Order.resize(Items.size());
+  for (GLuint i = 0; i < Items.size(); i++) {
+    Order[i] = i;
+    Items[i].slot = NONE;
+    Items[i].dirty = false;
+    writeItem(i);
+  }
+  Dirty.clear();
+  if (!Items.empty())
+    buildNode(NONE, 0, static_cast<GLuint>(Items.size()));
+  Refitted = static_cast<GLuint>(Items.size());
+  Built = true;
+}
+
+// Recomputes the bounds of a leaf from its items, then of its ancestors from
+// their children, stopping as soon as a box does not change.
+void PickingIndex::refitLeaf(const GLuint leaf) {
+  Node &node = Nodes[leaf];
+  glm::vec2 min(std::numeric_limits<GLfloat>::max()), max(-min);
+  for (GLuint i = node.firstItem; i < node.firstItem + node.itemCount; i++) {
+    min = glm::min(min, Items[Order[i]].min);
+    max = glm::max(max, Items[Order[i]].max);
+  }
+  GLuint index = leaf;
+  while (index != NONE) {
+    Node &n = Nodes[index];
+    if (n.right != 0) {
+      const Node &left = Nodes[index + 1];
+      const Node &right = Nodes[n.right];
+      min = glm::min(left.min, right.min);
+      max = glm::max(left.max, right.max);
+    }
+    if (min == n.min && max == n.max)
+      return;
+    n.min = min;
+    n.max = max;
+    index = n.parent;
+  }
+}
+
+void PickingIndex::update() {
+  if (!Built) {
+    build();
+    return;
+  }
+  Refitted = static_cast<GLuint>(Dirty.size());
+  for (GLuint item : Dirty) {
+    Items[item].dirty = false;
+    writeItem(item);
+  }
+  for (GLuint item : Dirty)
+    refitLeaf(Items[item].leaf);
+  Dirty.clear();
+}
+
+////////////////////////////////////////////////////////////////////// QUERIES
+
+// A point is inside a triangle when the three edge functions have the same
+// sign, whatever the winding of the triangle.
+GLuint PickingIndex::pickLeaf(const Node &leaf, const glm::vec2 &point) const {
+  GLuint best = NONE;
+#if MGL_PICKING_SSE2
+  const __m128 px = _mm_set1_ps(point.x);
+  const __m128 py = _mm_set1_ps(point.y);
+  const __m128 zero = _mm_setzero_ps();
+#endif
+  for (GLuint b = leaf.firstBlock; b < leaf.firstBlock + leaf.blockCount;
+       b++) {
+    const Block &block = Blocks[b];
+#if MGL_PICKING_SSE2
+    const __m128 x0 = _mm_loadu_ps(block.x0), y0 = _mm_loadu_ps(block.y0);
+    const __m128 x1 = _mm_loadu_ps(block.x1), y1 = _mm_loadu_ps(block.y1);
+    const __m128 x2 = _mm_loadu_ps(block.x2), y2 = _mm_loadu_ps(block.y2);
+    const __m128 e0 =
+        _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(x1, x0), _mm_sub_ps(py, y0)),
+                   _mm_mul_ps(_mm_sub_ps(y1, y0), _mm_sub_ps(px, x0)));
+    const __m128 e1 =
+        _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(x2, x1), _mm_sub_ps(py, y1)),
+                   _mm_mul_ps(_mm_sub_ps(y2, y1), _mm_sub_ps(px, x1)));
+    const __m128 e2 =
+        _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(x0, x2), _mm_sub_ps(py, y2)),
+                   _mm_mul_ps(_mm_sub_ps(y0, y2), _mm_sub_ps(px, x2)));
+    const __m128 positive =
+        _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+                   _mm_cmpge_ps(e2, zero));
+    const __m128 negative =
+        _mm_and_ps(_mm_and_ps(_mm_cmple_ps(e0, zero), _mm_cmple_ps(e1, zero)),
+                   _mm_cmple_ps(e2, zero));
+    const int mask = _mm_movemask_ps(_mm_or_ps(positive, negative));
+    for (GLuint lane = 0; lane < 4; lane++) {
+      if ((mask & (1 << lane)) &&
+          (best == NONE || block.item[lane] > best))
+        best = block.item[lane];
+    }
+#else
+    for (GLuint lane = 0; lane < 4; lane++) {
+      const GLfloat e0 =
+          (block.x1[lane] - block.x0[lane]) * (point.y - block.y0[lane]) -
+          (block.y1[lane] - block.y0[lane]) * (point.x - block.x0[lane]);
+      const GLfloat e1 =
+          (block.x2[lane] - block.x1[lane]) * (point.y - block.y1[lane]) -
+          (block.y2[lane] - block.y1[lane]) * (point.x - block.x1[lane]);
+      const GLfloat e2 =
+          (block.x0[lane] - block.x2[lane]) * (point.y - block.y2[lane]) -
+          (block.y0[lane] - block.y2[lane]) * (point.x - block.x2[lane]);
+      const bool inside = (e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f) ||
+                          (e0 <= 0.0f && e1 <= 0.0f && e2 <= 0.0f);
+      if (inside && (best == NONE || block.item[lane] > best))
+        best = block.item[lane];
+    }
+#endif
+  }
+  return best;
+}
+
+GLuint PickingIndex::pick(const glm::vec2 &point) const {
+  if (Nodes.empty())
+    return NONE;
+  GLuint best = NONE;
+  GLuint stack[64];
+  GLuint top = 0;
+  stack[top++] = 0;
+  while (top > 0) {
+    const Node &node = Nodes[stack[--top]];
+    if (point.x < node.min.x || point.y < node.min.y || point.x > node.max.x ||
+        point.y > node.max.y)
+      continue;
+    if (node.right == 0) {
+      const GLuint item = pickLeaf(node, point);
+      if (item != NONE && (best == NONE || item > best))
+        best = item;
+    } else {
+      stack[top++] = node.right;
+      stack[top++] = static_cast<GLuint>(&node - Nodes.data()) + 1;
+    }
+  }
+  return best;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
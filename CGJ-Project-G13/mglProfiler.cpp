@@ -0,0 +1,184 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Frame Profiler Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglProfiler.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace mgl {
+
+static const char *PHASE_NAMES[] = {"update", "clear", "display", "swap",
+                                    "events", "cpu",   "gpu"};
+
+////////////////////////////////////////////////////////////////// FrameProfiler
+
+FrameProfiler::FrameProfiler(bool record)
+    : DroppedQueries(0), FirstFrame(0), Frame(0), Record(record),
+      QueryNext(0), QueryActive(-1), Current() {
+  glGenQueries(QUERIES, Queries);
+  std::fill(QueryFrame, QueryFrame + QUERIES, -1);
+}
+
+FrameProfiler::~FrameProfiler() { glDeleteQueries(QUERIES, Queries); }
+
+void FrameProfiler::collectQueries() {
+  for (int i = 0; i < QUERIES; i++) {
+    if (QueryFrame[i] < 0 || i == QueryActive)
+      continue;
+    GLint available = 0;
+    glGetQueryObjectiv(Queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+      continue;
+    GLuint64 ns = 0;
+    glGetQueryObjectui64v(Queries[i], GL_QUERY_RESULT, &ns);
+    const long index = QueryFrame[i] - FirstFrame;
+    if (index >= 0 && index < static_cast<long>(Frames.size()))
+      Frames[index].ms[GPU] = ns / 1.0e6;
+    QueryFrame[i] = -1;
+  }
+}
+
+void FrameProfiler::beginFrame() {
+  collectQueries();
+  if (QueryFrame[QueryNext] < 0) {
+    glBeginQuery(GL_TIME_ELAPSED, Queries[QueryNext]);
+    QueryFrame[QueryNext] = Frame;
+    QueryActive = QueryNext;
+    QueryNext = (QueryNext + 1) % QUERIES;
+  } else {
+    DroppedQueries++;
+  }
+  std::fill(Current.ms, Current.ms + COLUMNS, 0.0);
+  Current.ms[GPU] = -1.0;
+  FrameStart = PhaseStart = Clock::now();
+}
+
+void FrameProfiler::mark(const Phase phase) {
+  const Clock::time_point now = Clock::now();
+  Current.ms[phase] +=
+      std::chrono::duration<double, std::milli>(now - PhaseStart).count();
+  PhaseStart = now;
+}
+
+void FrameProfiler::endGpu() {
+  if (QueryActive >= 0) {
+    glEndQuery(GL_TIME_ELAPSED);
+    QueryActive = -1;
+  }
+}
+
+void FrameProfiler::endFrame() {
+  endGpu();
+  Current.ms[CPU] =
+      std::chrono::duration<double, std::milli>(Clock::now() - FrameStart)
+          .count();
+  Frames.push_back(Current);
+  Frame++;
+  if (!Record && Frames.size() > WINDOW) {
+    Frames.pop_front();
+    FirstFrame++;
+  }
+}
+
+/////////////////////////////////////////////////////////////////// STATISTICS
+
+// Nearest-rank percentiles over the last WINDOW frames with a value
+FrameProfiler::Percentiles FrameProfiler::percentiles(const int column) {
+  std::vector<double> samples;
+  const size_t first = Frames.size() > WINDOW ? Frames.size() - WINDOW : 0;
+  for (size_t i = first; i < Frames.size(); i++) {
+    if (Frames[i].ms[column] >= 0.0)
+      samples.push_back(Frames[i].ms[column]);
+  }
+  if (samples.empty())
+    return {0.0, 0.0, 0.0};
+  std::sort(samples.begin(), samples.end());
+  auto rank = [&samples](double p) {
+    size_t i = static_cast<size_t>(p * samples.size());
+    return samples[std::min(i, samples.size() - 1)];
+  };
+  return {rank(0.50), rank(0.95), rank(0.99)};
+}
+
+FrameProfiler::Percentiles FrameProfiler::cpuPercentiles() {
+  return percentiles(CPU);
+}
+
+FrameProfiler::Percentiles FrameProfiler::gpuPercentiles() {
+  return percentiles(GPU);
+}
+
+FrameProfiler::Percentiles FrameProfiler::phasePercentiles(const Phase phase) {
+  return percentiles(phase);
+}
+
+void FrameProfiler::report(std::ostream &out) {
+  out << "Frame times over last " << std::min<size_t>(Frames.size(), WINDOW)
+      << " frames (ms, p50/p95/p99):" << std::endl;
+  for (int i = 0; i < COLUMNS; i++) {
+    Percentiles p = percentiles(i);
+    out << "  " << PHASE_NAMES[i] << ": " << p.p50 << " / " << p.p95 << " / "
+        << p.p99 << std::endl;
+  }
+  if (DroppedQueries > 0)
+    out << "  " << DroppedQueries << " frames without GPU timing" << std::endl;
+}
+
+///////////////////////////////////////////////////////////////////////// DUMP
+
+void FrameProfiler::writeCsv(std::ostream &out) {
+  out << "frame";
+  for (int i = 0; i < COLUMNS; i++)
+    out << "," << PHASE_NAMES[i];
+  out << std::endl;
+  for (size_t f = 0; f < Frames.size(); f++) {
+    out << FirstFrame + f;
+    for (int i = 0; i < COLUMNS; i++)
+      out << "," << Frames[f].ms[i];
+    out << std::endl;
+  }
+}
+
+void FrameProfiler::writeJson(std::ostream &out) {
+  out << "{" << std::endl << "  \"frames\": [" << std::endl;
+  for (size_t f = 0; f < Frames.size(); f++) {
+    out << "    {\"frame\": " << FirstFrame + f;
+    for (int i = 0; i < COLUMNS; i++)
+      out << ", \"" << PHASE_NAMES[i] << "\": " << Frames[f].ms[i];
+    out << "}" << (f + 1 < Frames.size() ? "," : "") << std::endl;
+  }
+  out << "  ]," << std::endl << "  \"percentiles\": {" << std::endl;
+  for (int i = 0; i < COLUMNS; i++) {
+    Percentiles p = percentiles(i);
+    out << "    \"" << PHASE_NAMES[i] << "\": [" << p.p50 << ", " << p.p95
+        << ", " << p.p99 << "]" << (i + 1 < COLUMNS ? "," : "") << std::endl;
+  }
+  out << "  }" << std::endl << "}" << std::endl;
+}
+
+// Format is picked from the extension: .json, anything else is CSV
+void FrameProfiler::write(const std::string &filename) {
+  collectQueries();
+  std::ofstream ofile(filename);
+  if (!ofile.is_open()) {
+    std::cerr << "[ERROR] Failed to open profile file: " << filename;
+    throw std::runtime_error("Failed to open profile file.");
+  }
+  const std::string json = ".json";
+  if (filename.size() >= json.size() &&
+      filename.compare(filename.size() - json.size(), json.size(), json) == 0)
+    writeJson(ofile);
+  else
+    writeCsv(ofile);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
@@ -0,0 +1,177 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Render Queue Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglRenderQueue.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "./mglState.hpp"
+
+namespace mgl {
+
+//////////////////////////////////////////////////////////////////// RenderQueue
+
+RenderQueue::RenderQueue(MeshPool *pool)
+    : BufferIds{0, 0}, ItemCount(0), DrawCalls(0), ProgramChanges(0),
+      Pool(pool) {
+  glGenBuffers(2, BufferIds);
+  MultiDraw = GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect;
+}
+
+RenderQueue::~RenderQueue() {
+  StateCache &state = StateCache::getInstance();
+  state.forgetBuffer(BufferIds[0]);
+  state.forgetBuffer(BufferIds[1]);
+  glDeleteBuffers(2, BufferIds);
+}
+
+void RenderQueue::setMaterialCallback(const MaterialCallback &callback) {
+  Material = callback;
+}
+
+void RenderQueue::push(const DrawItem &item) {
+  Keys.push_back({makeKey(item), static_cast<GLuint>(Items.size())});
+  Items.push_back(item);
+}
+
+void RenderQueue::clear() {
+  Items.clear();
+  Keys.clear();
+}
+
+GLuint64 RenderQueue::makeKey(const DrawItem &item) {
+  const GLuint next_program = static_cast<GLuint>(ProgramSlots.size());
+  const GLuint program =
+      ProgramSlots.insert({item.program, next_program}).first->second;
+  const GLuint next_mesh = static_cast<GLuint>(MeshSlots.size());
+  const MeshRange range(item.mesh.baseVertex, item.mesh.firstIndex,
+                        item.mesh.count);
+  const GLuint mesh = MeshSlots.insert({range, next_mesh}).first->second;
+  if (program > 0xFFF || mesh > 0xFFFF || item.layer > 0xF ||
+      item.material > 0xFFFF) {
+    std::cerr << "[WARNING] Render queue key field overflow" << std::endl;
+  }
+  const GLfloat depth = std::min(std::max(item.depth, 0.0f), 1.0f);
+  return (static_cast<GLuint64>(item.layer & 0xF) << 60) |
+         (static_cast<GLuint64>(program & 0xFFF) << 48) |
+         (static_cast<GLuint64>(item.material & 0xFFFF) << 32) |
+         (static_cast<GLuint64>(mesh & 0xFFFF) << 16) |
+         static_cast<GLuint64>(depth * 65535.0f);
+}
+
+// LSD radix sort, one byte per pass. Passes where every key has the same byte
+// are skipped, which is most of them since few fields vary within a frame.
+void RenderQueue::sort() {
+  Scratch.resize(Keys.size());
+  for (unsigned int shift = 0; shift < 64; shift += 8) {
+    size_t counts[256] = {};
+    for (const KeyIndex &k : Keys)
+      counts[(k.first >> shift) & 0xFF]++;
+    if (counts[(Keys[0].first >> shift) & 0xFF] == Keys.size())
+      continue;
+    size_t offset = 0;
+    for (size_t &c : counts) {
+      const size_t n = c;
+      c = offset;
+      offset += n;
+    }
+    for (const KeyIndex &k : Keys)
+      Scratch[counts[(k.first >> shift) & 0xFF]++] = k;
+    Keys.swap(Scratch);
+  }
+}
+
+void RenderQueue::submit() {
+  ItemCount = static_cast<GLuint>(Items.size());
+  DrawCalls = 0;
+  ProgramChanges = 0;
+  if (Items.empty())
+    return;
+  sort();
+
+  // One instanced draw per run of equal keys, ignoring depth
+  Instances.resize(Keys.size());
+  Commands.clear();
+  for (size_t i = 0; i < Keys.size(); i++) {
+    const DrawItem &item = Items[Keys[i].second];
+    Instances[i] = item.instance;
+    if (i > 0 && (Keys[i].first >> 16) == (Keys[i - 1].first >> 16)) {
+      Commands.back().instanceCount++;
+    } else {
+      Commands.push_back({static_cast<GLuint>(item.mesh.count), 1,
+                          item.mesh.firstIndex, item.mesh.baseVertex,
+                          static_cast<GLuint>(i)});
+    }
+  }
+
+  StateCache &state = StateCache::getInstance();
+  state.bindBuffer(GL_ARRAY_BUFFER, BufferIds[0]);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(InstanceData) * Instances.size(),
+               Instances.data(), GL_STREAM_DRAW);
+  state.bindBuffer(GL_ARRAY_BUFFER, 0);
+  Pool->bindInstanceBuffer(BufferIds[0], sizeof(InstanceData));
+  if (MultiDraw) {
+    state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, BufferIds[1]);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER,
+                 sizeof(DrawElementsCommand) * Commands.size(),
+                 Commands.data(), GL_STREAM_DRAW);
+  }
+
+  // One batch per run of commands sharing layer, program and material
+  Pool->bind();
+  ShaderProgram *bound = nullptr;
+  GLuint material = 0;
+  size_t first = 0;
+  size_t item = 0;
+  for (size_t c = 0; c < Commands.size(); c++) {
+    const DrawItem &current = Items[Keys[item].second];
+    item += Commands[c].instanceCount;
+    if (c + 1 < Commands.size() &&
+        (Keys[item].first >> 32) == (Keys[item - 1].first >> 32))
+      continue;
+    if (current.program != bound) {
+      bound = current.program;
+      bound->bind();
+      ProgramChanges++;
+      material = ~current.material; // forces the material callback
+    }
+    if (current.material != material) {
+      material = current.material;
+      if (Material)
+        Material(bound, material);
+    }
+    draw(first, c + 1);
+    first = c + 1;
+  }
+  Pool->unbind();
+  bound->unbind();
+  if (MultiDraw)
+    state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+  clear();
+}
+
+void RenderQueue::draw(const size_t first, const size_t last) {
+  if (MultiDraw) {
+    Pool->drawIndirect(first * sizeof(DrawElementsCommand),
+                       static_cast<GLsizei>(last - first));
+    DrawCalls++;
+    return;
+  }
+  for (size_t c = first; c < last; c++) {
+    const DrawElementsCommand &command = Commands[c];
+    Pool->drawInstanced({command.baseVertex, command.firstIndex,
+                         static_cast<GLsizei>(command.count)},
+                        command.instanceCount, command.baseInstance);
+    DrawCalls++;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
@@ -0,0 +1,198 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Dynamic Resolution Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglResolution.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+#include "./mglState.hpp"
+
+namespace mgl {
+
+////////////////////////////////////////////////////////////// DynamicResolution
+
+const int DynamicResolution::QUERIES;
+
+DynamicResolution::DynamicResolution(const double target_ms,
+                                     const Filter filter,
+                                     ShaderProgram *program)
+    : TargetMs(target_ms), MinScale(0.25f), MaxScale(1.0f), Gain(0.25f),
+      Upscale(filter), Scale(1.0f), GpuMs(-1.0), DroppedQueries(0),
+      Program(program), SourceSizeId{0}, TextureSizeId{0}, Framebuffer(0),
+      Texture(0), Depthbuffer(0), VertexArray(0), OutputWidth(0),
+      OutputHeight(0), Width(0), Height(0), QueryNext(0), QueryActive(-1),
+      Frames(0), ScaleSum(0.0), ScaleMin(1.0f), ScaleMax(0.0f) {
+  if (Upscale == EDGE_AWARE && Program) {
+    SourceSizeId = Program->getUniformHandle("SourceSize");
+    TextureSizeId = Program->getUniformHandle("TextureSize");
+  }
+  glGenFramebuffers(1, &Framebuffer);
+  glGenTextures(1, &Texture);
+  glGenRenderbuffers(1, &Depthbuffer);
+  glGenVertexArrays(1, &VertexArray);
+  glGenQueries(QUERIES * 2, &Queries[0][0]);
+  std::fill(QueryPending, QueryPending + QUERIES, false);
+}
+
+DynamicResolution::~DynamicResolution() {
+  StateCache &state = StateCache::getInstance();
+  state.forgetTexture(Texture);
+  state.forgetVertexArray(VertexArray);
+  state.forgetFramebuffer(Framebuffer);
+  glDeleteQueries(QUERIES * 2, &Queries[0][0]);
+  glDeleteVertexArrays(1, &VertexArray);
+  glDeleteRenderbuffers(1, &Depthbuffer);
+  glDeleteTextures(1, &Texture);
+  glDeleteFramebuffers(1, &Framebuffer);
+}
+
+GLsizei DynamicResolution::getWidth() const { return Width; }
+
+GLsizei DynamicResolution::getHeight() const { return Height; }
+
+void DynamicResolution::allocate() {
+  StateCache &state = StateCache::getInstance();
+  state.bindTexture(0, GL_TEXTURE_2D, Texture);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, OutputWidth, OutputHeight, 0,
+               GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  state.bindTexture(0, GL_TEXTURE_2D, 0);
+  glBindRenderbuffer(GL_RENDERBUFFER, Depthbuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, OutputWidth,
+                        OutputHeight);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  state.bindFramebuffer(GL_FRAMEBUFFER, Framebuffer);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         Texture, 0);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+                            GL_RENDERBUFFER, Depthbuffer);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    std::cerr << "[ERROR] Incomplete dynamic resolution framebuffer ("
+              << OutputWidth << "x" << OutputHeight << ")" << std::endl;
+    throw std::runtime_error("Failed to create scene framebuffer.");
+  }
+}
+
+void DynamicResolution::collectQueries() {
+  for (int i = 0; i < QUERIES; i++) {
+    if (!QueryPending[i] || i == QueryActive)
+      continue;
+    GLint available = 0;
+    glGetQueryObjectiv(Queries[i][1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+      continue;
+    GLuint64 start = 0, stop = 0;
+    glGetQueryObjectui64v(Queries[i][0], GL_QUERY_RESULT, &start);
+    glGetQueryObjectui64v(Queries[i][1], GL_QUERY_RESULT, &stop);
+    QueryPending[i] = false;
+    adjust((stop - start) / 1.0e6);
+  }
+}
+
+void DynamicResolution::adjust(const double gpu_ms) {
+  GpuMs = gpu_ms;
+  if (gpu_ms <= 0.0)
+    return;
+  const GLfloat wanted = std::min(
+      std::max(Scale * static_cast<GLfloat>(std::sqrt(TargetMs / gpu_ms)),
+               MinScale),
+      MaxScale);
+  if (std::fabs(wanted - Scale) > 0.01f * Scale)
+    Scale += (wanted - Scale) * Gain;
+  else if (wanted == MinScale || wanted == MaxScale)
+    Scale = wanted; // the dead band would otherwise stop short of a limit
+}
+
+// Binds the scene framebuffer with a viewport of the current scale, where
+// the caller then clears and draws as usual
+void DynamicResolution::begin(const GLsizei width, const GLsizei height) {
+  if (width <= 0 || height <= 0)
+    return;
+  if (width != OutputWidth || height != OutputHeight) {
+    OutputWidth = width;
+    OutputHeight = height;
+    allocate();
+  }
+  collectQueries();
+  Scale = std::min(std::max(Scale, MinScale), MaxScale);
+  Width = std::max(1, static_cast<GLsizei>(std::lround(OutputWidth * Scale)));
+  Height =
+      std::max(1, static_cast<GLsizei>(std::lround(OutputHeight * Scale)));
+  Frames++;
+  ScaleSum += Scale;
+  ScaleMin = std::min(ScaleMin, Scale);
+  ScaleMax = std::max(ScaleMax, Scale);
+
+  StateCache &state = StateCache::getInstance();
+  state.bindFramebuffer(GL_FRAMEBUFFER, Framebuffer);
+  state.viewport(0, 0, Width, Height);
+  if (!QueryPending[QueryNext]) {
+    glQueryCounter(Queries[QueryNext][0], GL_TIMESTAMP);
+    QueryPending[QueryNext] = true;
+    QueryActive = QueryNext;
+    QueryNext = (QueryNext + 1) % QUERIES;
+  } else {
+    DroppedQueries++;
+  }
+}
+
+// Upscales the scene into the target framebuffer, which is left bound with a
+// viewport covering the whole output
+void DynamicResolution::end(const GLuint target) {
+  if (OutputWidth <= 0 || OutputHeight <= 0)
+    return;
+  if (QueryActive >= 0) {
+    glQueryCounter(Queries[QueryActive][1], GL_TIMESTAMP);
+    QueryActive = -1;
+  }
+  StateCache &state = StateCache::getInstance();
+  if (Upscale == EDGE_AWARE && Program && Program->isReady()) {
+    state.bindFramebuffer(GL_FRAMEBUFFER, target);
+    state.viewport(0, 0, OutputWidth, OutputHeight);
+    const bool depth_test = state.isEnabled(GL_DEPTH_TEST);
+    state.disable(GL_DEPTH_TEST);
+    state.bindTexture(0, GL_TEXTURE_2D, Texture);
+    state.bindVertexArray(VertexArray);
+    Program->bind();
+    Program->setUniform(SourceSizeId, glm::vec2(Width, Height));
+    Program->setUniform(TextureSizeId, glm::vec2(OutputWidth, OutputHeight));
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    Program->unbind();
+    state.bindVertexArray(0);
+    state.bindTexture(0, GL_TEXTURE_2D, 0);
+    if (depth_test)
+      state.enable(GL_DEPTH_TEST);
+  } else {
+    state.bindFramebuffer(GL_READ_FRAMEBUFFER, Framebuffer);
+    state.bindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+    glBlitFramebuffer(0, 0, Width, Height, 0, 0, OutputWidth, OutputHeight,
+                      GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    state.bindFramebuffer(GL_FRAMEBUFFER, target);
+    state.viewport(0, 0, OutputWidth, OutputHeight);
+  }
+}
+
+void DynamicResolution::report(std::ostream &out) const {
+  if (Frames == 0)
+    return;
+  out << "Dynamic resolution: scale " << ScaleSum / Frames << " average ("
+      << ScaleMin << " - " << ScaleMax << "), last scene " << GpuMs
+      << " ms for a budget of " << TargetMs << " ms, "
+      << (Upscale == EDGE_AWARE ? "edge-aware" : "bilinear") << " upscale"
+      << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
@@ -0,0 +1,489 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Binary Scene File Classes
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglScene.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "./mglState.hpp"
+
+namespace mgl {
+
+static void checkHeader(const SceneHeader &header,
+                        const std::string &filename) {
+  if (std::memcmp(header.magic, SCENE_MAGIC, sizeof(SCENE_MAGIC)) != 0) {
+    std::cerr << "[ERROR] Not a scene file: " << filename << std::endl;
+    throw std::runtime_error("Not a scene file.");
+  }
+  if (header.version != SCENE_VERSION) {
+    std::cerr << "[ERROR] Scene file " << filename << " has version "
+              << header.version << ", expected " << SCENE_VERSION
+              << std::endl;
+    throw std::runtime_error("Unsupported scene file version.");
+  }
+}
+
+static void truncated(const std::string &filename) {
+  std::cerr << "[ERROR] Scene file " << filename << " is truncated"
+            << std::endl;
+  throw std::runtime_error("Truncated scene file.");
+}
+
+static void corrupt(const std::string &filename, const std::string &what) {
+  std::cerr << "[ERROR] Scene file " << filename << " has " << what
+            << std::endl;
+  throw std::runtime_error("Corrupt scene file.");
+}
+
+// Size of one record of a section, 0 if its format is not valid for its type
+static GLuint64 getRecordSize(const SceneSection &section) {
+  switch (section.type) {
+  case SceneSectionType::VERTICES:
+    return section.format;
+  case SceneSectionType::INDICES:
+    if (section.format != GL_UNSIGNED_BYTE &&
+        section.format != GL_UNSIGNED_SHORT &&
+        section.format != GL_UNSIGNED_INT)
+      return 0;
+    return MeshPool::getIndexSize(section.format);
+  case SceneSectionType::MESHES:
+    return section.format == sizeof(SceneMesh) ? sizeof(SceneMesh) : 0;
+  case SceneSectionType::INSTANCES:
+    return section.format == sizeof(InstanceData) ? sizeof(InstanceData) : 0;
+  default:
+    return 0;
+  }
+}
+
+static bool isKnownSection(const SceneSection &section) {
+  return section.type >= SceneSectionType::VERTICES &&
+         section.type <= SceneSectionType::INSTANCES;
+}
+
+static void checkSection(const SceneSection &section, const GLuint64 size,
+                         const std::string &filename) {
+  if (section.offset % SCENE_ALIGNMENT != 0 || section.offset > size ||
+      section.size > size - section.offset) {
+    truncated(filename);
+  }
+  if (!isKnownSection(section))
+    return; // left to whoever knows what is in it
+  const GLuint64 record = getRecordSize(section);
+  if (record == 0) {
+    corrupt(filename, "a section of unknown format " +
+                          std::to_string(section.format));
+  }
+  if (section.count > section.size / record) {
+    corrupt(filename, "a section of " + std::to_string(section.count) +
+                          " records in " + std::to_string(section.size) +
+                          " bytes");
+  }
+}
+
+static GLuint64 getRecordCount(const SceneSection *sections,
+                               const GLuint section_count,
+                               const SceneSectionType type) {
+  for (GLuint i = 0; i < section_count; i++) {
+    if (sections[i].type == type)
+      return sections[i].count;
+  }
+  return 0;
+}
+
+// Meshes must only reference records the other sections hold. Index values
+// themselves are not checked, that would take a pass over the whole buffer.
+static void checkMeshes(const SceneMesh *meshes, const GLuint64 mesh_count,
+                        const SceneSection *sections,
+                        const GLuint section_count,
+                        const std::string &filename) {
+  const GLuint64 vertices = getRecordCount(sections, section_count,
+                                           SceneSectionType::VERTICES);
+  const GLuint64 indices =
+      getRecordCount(sections, section_count, SceneSectionType::INDICES);
+  const GLuint64 instances = getRecordCount(sections, section_count,
+                                            SceneSectionType::INSTANCES);
+  for (GLuint64 i = 0; i < mesh_count; i++) {
+    const SceneMesh &m = meshes[i];
+    if (m.baseVertex < 0 || static_cast<GLuint64>(m.baseVertex) > vertices ||
+        m.firstIndex > indices || m.count > indices - m.firstIndex ||
+        m.firstInstance > instances ||
+        m.instanceCount > instances - m.firstInstance) {
+      corrupt(filename, "mesh " + std::to_string(i) + " out of range");
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////// SceneFile
+
+SceneFile::SceneFile(const std::string &filename)
+    : Data(nullptr), Size(0), Sections(nullptr), SectionCount(0) {
+  map(filename);
+  try {
+    if (Size < sizeof(SceneHeader)) {
+      truncated(filename);
+    }
+    const SceneHeader *header = reinterpret_cast<const SceneHeader *>(Data);
+    checkHeader(*header, filename);
+    SectionCount = header->sectionCount;
+    if (SectionCount > (Size - sizeof(SceneHeader)) / sizeof(SceneSection)) {
+      truncated(filename);
+    }
+    Sections =
+        reinterpret_cast<const SceneSection *>(Data + sizeof(SceneHeader));
+    for (GLuint i = 0; i < SectionCount; i++)
+      checkSection(Sections[i], Size, filename);
+    if (hasSection(SceneSectionType::MESHES)) {
+      checkMeshes(getMeshes(), getMeshCount(), Sections, SectionCount,
+                  filename);
+    }
+  } catch (...) {
+    unmap();
+    throw;
+  }
+}
+
+SceneFile::~SceneFile() { unmap(); }
+
+#ifdef _WIN32
+
+void SceneFile::map(const std::string &filename) {
+  FileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                           nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                           nullptr);
+  MappingHandle = nullptr;
+  if (FileHandle == INVALID_HANDLE_VALUE) {
+    std::cerr << "[ERROR] Failed to open scene file: " << filename
+              << std::endl;
+    throw std::runtime_error("Failed to open scene file.");
+  }
+  LARGE_INTEGER size;
+  GetFileSizeEx(FileHandle, &size);
+  Size = static_cast<size_t>(size.QuadPart);
+  MappingHandle =
+      CreateFileMappingA(FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (MappingHandle)
+    Data = static_cast<const GLubyte *>(
+        MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0));
+  if (!Data) {
+    unmap();
+    std::cerr << "[ERROR] Failed to map scene file: " << filename
+              << std::endl;
+    throw std::runtime_error("Failed to map scene file.");
+  }
+}
+
+void SceneFile::unmap() {
+  if (Data)
+    UnmapViewOfFile(Data);
+  if (MappingHandle)
+    CloseHandle(MappingHandle);
+  if (FileHandle != INVALID_HANDLE_VALUE)
+    CloseHandle(FileHandle);
+  Data = nullptr;
+  MappingHandle = nullptr;
+  FileHandle = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+void SceneFile::map(const std::string &filename) {
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    std::cerr << "[ERROR] Failed to open scene file: " << filename
+              << std::endl;
+    throw std::runtime_error("Failed to open scene file.");
+  }
+  struct stat info;
+  fstat(fd, &info);
+  Size = static_cast<size_t>(info.st_size);
+  void *data = mmap(nullptr, Size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); // the mapping keeps the file open
+  if (data == MAP_FAILED) {
+    std::cerr << "[ERROR] Failed to map scene file: " << filename
+              << std::endl;
+    throw std::runtime_error("Failed to map scene file.");
+  }
+  Data = static_cast<const GLubyte *>(data);
+}
+
+void SceneFile::unmap() {
+  if (Data)
+    munmap(const_cast<GLubyte *>(Data), Size);
+  Data = nullptr;
+}
+
+#endif
+
+bool SceneFile::hasSection(const SceneSectionType type) const {
+  for (GLuint i = 0; i < SectionCount; i++) {
+    if (Sections[i].type == type)
+      return true;
+  }
+  return false;
+}
+
+const SceneSection &SceneFile::getSection(const SceneSectionType type) const {
+  for (GLuint i = 0; i < SectionCount; i++) {
+    if (Sections[i].type == type)
+      return Sections[i];
+  }
+  throw std::runtime_error("Scene section not found.");
+}
+
+const void *SceneFile::getData(const SceneSectionType type) const {
+  return Data + getSection(type).offset;
+}
+
+const SceneMesh *SceneFile::getMeshes() const {
+  return static_cast<const SceneMesh *>(getData(SceneSectionType::MESHES));
+}
+
+GLuint SceneFile::getMeshCount() const {
+  return static_cast<GLuint>(getSection(SceneSectionType::MESHES).count);
+}
+
+// The pool must have been built with the same vertex layout as the file
+void SceneFile::createMeshPool(MeshPool &pool) const {
+  const SceneSection &vertices = getSection(SceneSectionType::VERTICES);
+  const SceneSection &indices = getSection(SceneSectionType::INDICES);
+  if (vertices.format != static_cast<GLuint>(pool.getVertexSize())) {
+    throw std::runtime_error("Scene vertex stride does not match MeshPool.");
+  }
+  const SceneMesh *meshes = getMeshes();
+  for (GLuint i = 0; i < getMeshCount(); i++) {
+    const SceneMesh &m = meshes[i];
+    const std::string name(m.name,
+                           std::find(m.name, m.name + sizeof(m.name), '\0'));
+    pool.Meshes[name] = {m.baseVertex, m.firstIndex,
+                         static_cast<GLsizei>(m.count)};
+  }
+  pool.create(Data + vertices.offset, vertices.size, Data + indices.offset,
+              indices.size, indices.format);
+}
+
+void SceneFile::createInstanceBuffer(const GLuint buffer_id) const {
+  const SceneSection &instances = getSection(SceneSectionType::INSTANCES);
+  StateCache &state = StateCache::getInstance();
+  state.bindBuffer(GL_ARRAY_BUFFER, buffer_id);
+  glBufferStorage(GL_ARRAY_BUFFER, instances.size, Data + instances.offset, 0);
+  state.bindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+//////////////////////////////////////////////////////////////////// SceneStream
+
+const size_t SceneStream::CHUNK_SIZE;
+
+SceneStream::SceneStream(const std::string &filename)
+    : File(filename, std::ios::binary) {
+  if (!File.is_open()) {
+    std::cerr << "[ERROR] Failed to open scene file: " << filename
+              << std::endl;
+    throw std::runtime_error("Failed to open scene file.");
+  }
+  File.seekg(0, std::ios::end);
+  const GLuint64 size = static_cast<GLuint64>(File.tellg());
+  File.seekg(0, std::ios::beg);
+  SceneHeader header = {};
+  File.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (!File) {
+    truncated(filename);
+  }
+  checkHeader(header, filename);
+  if (header.sectionCount > (size - sizeof(header)) / sizeof(SceneSection)) {
+    truncated(filename);
+  }
+  Sections.resize(header.sectionCount);
+  File.read(reinterpret_cast<char *>(Sections.data()),
+            Sections.size() * sizeof(SceneSection));
+  if (!File) {
+    truncated(filename);
+  }
+  for (auto &s : Sections)
+    checkSection(s, size, filename);
+  for (auto &s : Sections) {
+    if (s.type != SceneSectionType::MESHES)
+      continue;
+    std::vector<SceneMesh> meshes(static_cast<size_t>(s.count));
+    File.seekg(s.offset);
+    File.read(reinterpret_cast<char *>(meshes.data()),
+              meshes.size() * sizeof(SceneMesh));
+    if (!File) {
+      truncated(filename);
+    }
+    checkMeshes(meshes.data(), meshes.size(), Sections.data(),
+                static_cast<GLuint>(Sections.size()), filename);
+  }
+}
+
+const std::vector<SceneSection> &SceneStream::getSections() const {
+  return Sections;
+}
+
+const SceneSection &SceneStream::getSection(const SceneSectionType type) const {
+  for (auto &s : Sections) {
+    if (s.type == type)
+      return s;
+  }
+  throw std::runtime_error("Scene section not found.");
+}
+
+void SceneStream::read(
+    const SceneSectionType type,
+    const std::function<void(const GLubyte *, size_t)> &consumer) {
+  const SceneSection &section = getSection(type);
+  Chunk.resize(CHUNK_SIZE);
+  File.seekg(section.offset);
+  for (GLuint64 done = 0; done < section.size;) {
+    const size_t n = static_cast<size_t>(
+        std::min<GLuint64>(CHUNK_SIZE, section.size - done));
+    File.read(reinterpret_cast<char *>(Chunk.data()), n);
+    if (static_cast<size_t>(File.gcount()) != n) {
+      std::cerr << "[ERROR] Scene file ended inside a section" << std::endl;
+      throw std::runtime_error("Truncated scene file.");
+    }
+    consumer(Chunk.data(), n);
+    done += n;
+  }
+}
+
+// The buffer gets immutable storage of the section's size. On failure the
+// buffer is left unbound, with undefined contents.
+void SceneStream::upload(const SceneSectionType type, const GLenum target,
+                         const GLuint buffer_id) {
+  const SceneSection &section = getSection(type);
+  StateCache &state = StateCache::getInstance();
+  state.bindBuffer(target, buffer_id);
+  glBufferStorage(target, section.size, nullptr, GL_MAP_WRITE_BIT);
+  File.seekg(section.offset);
+  for (GLuint64 done = 0; done < section.size;) {
+    const size_t n = static_cast<size_t>(
+        std::min<GLuint64>(CHUNK_SIZE, section.size - done));
+    void *mapped = glMapBufferRange(target, done, n,
+                                    GL_MAP_WRITE_BIT |
+                                        GL_MAP_INVALIDATE_RANGE_BIT);
+    if (!mapped) {
+      state.bindBuffer(target, 0);
+      std::cerr << "[ERROR] Failed to map " << n << " bytes of buffer "
+                << buffer_id << " for a scene section" << std::endl;
+      throw std::runtime_error("Failed to map scene buffer.");
+    }
+    File.read(static_cast<char *>(mapped), n);
+    const bool complete = static_cast<size_t>(File.gcount()) == n;
+    const bool intact = glUnmapBuffer(target) == GL_TRUE;
+    if (!complete || !intact) {
+      state.bindBuffer(target, 0);
+      std::cerr << "[ERROR] Failed to upload a scene section: "
+                << (complete ? "buffer contents lost" : "file ended early")
+                << std::endl;
+      throw std::runtime_error(complete ? "Failed to upload scene section."
+                                        : "Truncated scene file.");
+    }
+    done += n;
+  }
+  state.bindBuffer(target, 0);
+}
+
+//////////////////////////////////////////////////////////////////// SceneWriter
+
+void SceneWriter::setBlob(const Blob &blob) {
+  for (auto &b : Blobs) {
+    if (b.type == blob.type) {
+      b = blob;
+      return;
+    }
+  }
+  Blobs.push_back(blob);
+}
+
+void SceneWriter::setVertices(const void *data, const GLuint64 size,
+                              const GLuint stride) {
+  setBlob({SceneSectionType::VERTICES, stride, data, size, size / stride});
+}
+
+void SceneWriter::setIndices(const void *data, const GLuint64 size,
+                             const GLenum index_type) {
+  setBlob({SceneSectionType::INDICES, index_type, data, size,
+           size / MeshPool::getIndexSize(index_type)});
+}
+
+void SceneWriter::setInstances(const InstanceData *data, const GLuint count) {
+  setBlob({SceneSectionType::INSTANCES, sizeof(InstanceData), data,
+           sizeof(InstanceData) * count, count});
+}
+
+void SceneWriter::addMesh(const std::string &name, const Mesh &mesh,
+                          const GLuint first_instance,
+                          const GLuint instance_count) {
+  SceneMesh m = {};
+  if (name.size() > sizeof(m.name)) {
+    throw std::runtime_error("Scene mesh name too long.");
+  }
+  std::memcpy(m.name, name.data(), name.size());
+  m.baseVertex = mesh.baseVertex;
+  m.firstIndex = mesh.firstIndex;
+  m.count = static_cast<GLuint>(mesh.count);
+  m.firstInstance = first_instance;
+  m.instanceCount = instance_count;
+  Meshes.push_back(m);
+}
+
+void SceneWriter::write(const std::string &filename) const {
+  std::vector<Blob> blobs = Blobs;
+  blobs.push_back({SceneSectionType::MESHES, sizeof(SceneMesh), Meshes.data(),
+                   sizeof(SceneMesh) * Meshes.size(), Meshes.size()});
+
+  SceneHeader header = {};
+  std::memcpy(header.magic, SCENE_MAGIC, sizeof(SCENE_MAGIC));
+  header.version = SCENE_VERSION;
+  header.sectionCount = static_cast<GLuint>(blobs.size());
+
+  std::vector<SceneSection> sections;
+  GLuint64 offset = sizeof(SceneHeader) + sizeof(SceneSection) * blobs.size();
+  for (auto &b : blobs) {
+    offset = (offset + SCENE_ALIGNMENT - 1) / SCENE_ALIGNMENT * SCENE_ALIGNMENT;
+    sections.push_back({b.type, b.format, offset, b.size, b.count});
+    offset += b.size;
+  }
+
+  std::ofstream ofile(filename, std::ios::binary);
+  if (!ofile.is_open()) {
+    std::cerr << "[ERROR] Failed to open scene file: " << filename
+              << std::endl;
+    throw std::runtime_error("Failed to open scene file.");
+  }
+  ofile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  ofile.write(reinterpret_cast<const char *>(sections.data()),
+              sizeof(SceneSection) * sections.size());
+  for (size_t i = 0; i < blobs.size(); i++) {
+    const GLuint64 position = static_cast<GLuint64>(ofile.tellp());
+    const std::vector<char> padding(sections[i].offset - position, 0);
+    ofile.write(padding.data(), padding.size());
+    ofile.write(static_cast<const char *>(blobs[i].data), blobs[i].size);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
@@ -0,0 +1,104 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Uniform Buffer Ring Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglUniformBuffer.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include "./mglState.hpp"
+
+namespace mgl {
+
+////////////////////////////////////////////////////////////// UniformBufferRing
+
+UniformBufferRing::UniformBufferRing(const GLsizeiptr frame_size)
+    : BufferId(0), Stalls(0), Mapped(nullptr), Alignment(256), Frame(0),
+      Offset(0), Fences{} {
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &Alignment);
+  FrameSize = (frame_size + Alignment - 1) / Alignment * Alignment;
+
+  const GLbitfield flags =
+      GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  StateCache &state = StateCache::getInstance();
+  glGenBuffers(1, &BufferId);
+  state.bindBuffer(GL_UNIFORM_BUFFER, BufferId);
+  glBufferStorage(GL_UNIFORM_BUFFER, FrameSize * FRAMES, nullptr, flags);
+  Mapped = static_cast<GLubyte *>(
+      glMapBufferRange(GL_UNIFORM_BUFFER, 0, FrameSize * FRAMES, flags));
+  state.bindBuffer(GL_UNIFORM_BUFFER, 0);
+  if (!Mapped) {
+    throw std::runtime_error("Failed to map uniform buffer ring.");
+  }
+}
+
+UniformBufferRing::~UniformBufferRing() {
+  for (GLsync &fence : Fences) {
+    if (fence)
+      glDeleteSync(fence);
+  }
+  StateCache &state = StateCache::getInstance();
+  state.bindBuffer(GL_UNIFORM_BUFFER, BufferId);
+  glUnmapBuffer(GL_UNIFORM_BUFFER);
+  state.forgetBuffer(BufferId);
+  glDeleteBuffers(1, &BufferId);
+}
+
+void UniformBufferRing::beginFrame() {
+  GLsync &fence = Fences[Frame];
+  if (fence) {
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+      Stalls++;
+      do {
+        status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                  1000000); // 1 ms
+      } while (status == GL_TIMEOUT_EXPIRED);
+    }
+    if (status == GL_WAIT_FAILED) {
+      std::cerr << "[WARNING] Uniform buffer ring fence wait failed"
+                << std::endl;
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+  }
+  Offset = 0;
+}
+
+GLintptr UniformBufferRing::write(const void *data, const GLsizeiptr size) {
+  if (Offset + size > FrameSize) {
+    throw std::runtime_error("Uniform buffer ring frame region overflow.");
+  }
+  const GLintptr offset = Frame * FrameSize + Offset;
+  std::memcpy(Mapped + offset, data, size);
+  Offset = (Offset + size + Alignment - 1) / Alignment * Alignment;
+  return offset;
+}
+
+void UniformBufferRing::bindRange(const GLuint binding_point,
+                                  const GLintptr offset,
+                                  const GLsizeiptr size) {
+  StateCache::getInstance().bindBufferRange(GL_UNIFORM_BUFFER, binding_point,
+                                            BufferId, offset, size);
+}
+
+GLintptr UniformBufferRing::push(const GLuint binding_point, const void *data,
+                                 const GLsizeiptr size) {
+  const GLintptr offset = write(data, size);
+  bindRange(binding_point, offset, size);
+  return offset;
+}
+
+void UniformBufferRing::endFrame() {
+  Fences[Frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  Frame = (Frame + 1) % FRAMES;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
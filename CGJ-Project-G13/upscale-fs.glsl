@@ -0,0 +1,30 @@
+#version 330 core
+
+uniform sampler2D Scene;
+uniform vec2 SourceSize;  // scene pixels, in the lower left corner of the texture
+uniform vec2 TextureSize; // output pixels, also the size of the texture
+
+out vec4 outColor;
+
+float luma(vec3 color) {
+    return dot(color, vec3(0.299, 0.587, 0.114));
+}
+
+void main(void) {
+    // Bilinear footprint in the source, kept inside the rendered corner
+    vec2 p = clamp(gl_FragCoord.xy * SourceSize / TextureSize, vec2(0.5), SourceSize - 0.5) - 0.5;
+    vec2 f = fract(p);
+    ivec2 c = ivec2(floor(p));
+    ivec2 last = ivec2(SourceSize) - 1;
+    vec4 t00 = texelFetch(Scene, c, 0);
+    vec4 t10 = texelFetch(Scene, min(c + ivec2(1, 0), last), 0);
+    vec4 t01 = texelFetch(Scene, min(c + ivec2(0, 1), last), 0);
+    vec4 t11 = texelFetch(Scene, min(c + ivec2(1, 1), last), 0);
+
+    // Texels unlike the nearest one lose their weight, so edges are not blurred across
+    vec4 nearest = f.y < 0.5 ? (f.x < 0.5 ? t00 : t10) : (f.x < 0.5 ? t01 : t11);
+    vec4 l = vec4(luma(t00.rgb), luma(t10.rgb), luma(t01.rgb), luma(t11.rgb)) - luma(nearest.rgb);
+    vec4 w = vec4((1.0 - f.x) * (1.0 - f.y), f.x * (1.0 - f.y), (1.0 - f.x) * f.y, f.x * f.y);
+    w *= exp(-64.0 * l * l);
+    outColor = (t00 * w.x + t10 * w.y + t01 * w.z + t11 * w.w) / dot(w, vec4(1.0));
+}
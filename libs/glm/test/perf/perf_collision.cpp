@@ -0,0 +1,141 @@
+#include <glm/ext/matrix_transform.hpp>
+#include "../../../mgl/mglCollision.hpp"
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+typedef std::vector<std::pair<GLuint, GLuint> > pairs;
+
+// The outlines of the tangram triangle, square and parallelogram
+static void add_shapes(mgl::CollisionWorld& World)
+{
+	glm::vec2 const Triangle[] = {{-0.5f, -0.5f}, {0.5f, -0.5f}, {-0.5f, 0.5f}};
+	glm::vec2 const Square[] = {{-0.5f, -0.5f}, {0.5f, -0.5f}, {0.5f, 0.5f}, {-0.5f, 0.5f}};
+	glm::vec2 const Parallelogram[] = {{-1.0f, -0.5f}, {0.0f, -0.5f}, {0.0f, 0.5f}, {1.0f, 0.5f}};
+	World.addShape(Triangle, 3);
+	World.addShape(Square, 4);
+	World.addShape(Parallelogram, 4);
+}
+
+static pairs sorted(pairs Pairs)
+{
+	for(std::pair<GLuint, GLuint>& Pair : Pairs)
+		if(Pair.first > Pair.second)
+			std::swap(Pair.first, Pair.second);
+	std::sort(Pairs.begin(), Pairs.end());
+	return Pairs;
+}
+
+static pairs contact_pairs(mgl::CollisionWorld const& World)
+{
+	pairs Pairs;
+	for(mgl::Contact const& Contact : World.getContacts())
+		Pairs.push_back(std::make_pair(Contact.a, Contact.b));
+	return sorted(Pairs);
+}
+
+// The separating axis test of every pair, as if there were no broadphase
+static pairs all_pairs(mgl::CollisionWorld const& World)
+{
+	pairs Pairs;
+	mgl::Contact Contact;
+	for(GLuint a = 0; a < World.size(); ++a)
+	for(GLuint b = a + 1; b < World.size(); ++b)
+		if(World.test(a, b, Contact))
+			Pairs.push_back(std::make_pair(a, b));
+	return Pairs;
+}
+
+// Count pieces scattered at random, all of them moved a little every update, as when a whole board is being
+// shuffled. Every Check updates, the contacts found are compared with those of an all-pairs test.
+static int test_scattered(int Count, int Updates, int Check)
+{
+	int Error = 0;
+
+	mgl::CollisionWorld World;
+	add_shapes(World);
+	std::mt19937 Random(1);
+	std::uniform_real_distribution<float> Uniform(-1.0f, 1.0f);
+	float const Side = std::sqrt(static_cast<float>(Count));
+	std::vector<glm::mat4> Matrices;
+	for(int i = 0; i < Count; ++i)
+	{
+		glm::mat4 const M = glm::translate(glm::mat4(1.0f), glm::vec3(Uniform(Random), Uniform(Random), 0.0f) * Side);
+		Matrices.push_back(glm::rotate(M, Uniform(Random) * 3.14159f, glm::vec3(0.0f, 0.0f, 1.0f)));
+		World.addBody(static_cast<GLuint>(i % 3), Matrices.back());
+	}
+	World.update();
+
+	double Seconds = 0.0, AllSeconds = 0.0;
+	std::size_t Tests = 0, Contacts = 0;
+	int Checks = 0;
+	for(int u = 0; u < Updates; ++u)
+	{
+		for(int i = 0; i < Count; ++i)
+		{
+			Matrices[i] = glm::translate(Matrices[i], glm::vec3(Uniform(Random), Uniform(Random), 0.0f) * 0.02f);
+			World.setMatrix(static_cast<GLuint>(i), Matrices[i]);
+		}
+		std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+		World.update();
+		std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+		Seconds += std::chrono::duration<double>(t2 - t1).count();
+		Tests += World.PairsTested;
+		Contacts += World.getContacts().size();
+
+		if(u % Check == 0)
+		{
+			t1 = std::chrono::steady_clock::now();
+			pairs const All = all_pairs(World);
+			t2 = std::chrono::steady_clock::now();
+			AllSeconds += std::chrono::duration<double>(t2 - t1).count();
+			Error += contact_pairs(World) == All ? 0 : 1;
+			++Checks;
+		}
+	}
+
+	std::printf("%d pieces, SSE2: %d\n", Count, MGL_COLLISION_SSE2);
+	std::printf("- sweep and prune: %.3f ms per update, %d pair tests and %d contacts per update\n",
+		Seconds / Updates * 1000.0, static_cast<int>(Tests / Updates), static_cast<int>(Contacts / Updates));
+	std::printf("- all pairs: %.3f ms per update, %d pair tests\n",
+		AllSeconds / Checks * 1000.0, Count * (Count - 1) / 2);
+
+	// Scattered over about one piece per unit square, some of them overlap
+	Error += Contacts > 0 ? 0 : 1;
+	Error += Tests < static_cast<std::size_t>(Updates) * Count * (Count - 1) / 2 ? 0 : 1;
+
+	return Error;
+}
+
+// Touching and barely separated squares, where contacts within Slop are still reported
+static int test_touching()
+{
+	int Error = 0;
+
+	mgl::CollisionWorld World;
+	add_shapes(World);
+	for(int i = 0; i < 8; ++i)
+		World.addBody(1, glm::translate(glm::mat4(1.0f), glm::vec3(static_cast<float>(i) * (1.0f + World.Slop * 0.5f), 0.0f, 0.0f)));
+	World.update();
+
+	Error += World.getContacts().size() == 7 ? 0 : 1;
+	Error += contact_pairs(World) == all_pairs(World) ? 0 : 1;
+
+	return Error;
+}
+
+int main()
+{
+	int Error = 0;
+
+	Error += test_touching();
+	Error += test_scattered(64, 240, 1);
+	Error += test_scattered(1024, 240, 16);
+	Error += test_scattered(10000, 60, 30);
+
+	return Error;
+}
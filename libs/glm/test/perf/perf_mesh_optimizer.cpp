@@ -0,0 +1,132 @@
+#include <glm/vec2.hpp>
+#include "../../../mgl/mglMeshOptimizer.hpp"
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+typedef std::array<glm::vec2, 3> triangle;
+
+struct mesh
+{
+	std::vector<glm::vec2> Vertices;
+	std::vector<GLuint> Indices;
+};
+
+// An N x N grid of quads as a triangle soup: every triangle has its own three
+// vertices and the triangles are shuffled, as a careless exporter would write it
+static mesh make_soup(int N)
+{
+	std::vector<triangle> Triangles;
+	for(int y = 0; y < N; ++y)
+	for(int x = 0; x < N; ++x)
+	{
+		glm::vec2 const A(x, y), B(x + 1, y), C(x + 1, y + 1), D(x, y + 1);
+		Triangles.push_back({{A, B, C}});
+		Triangles.push_back({{A, C, D}});
+	}
+	unsigned int Seed = 1;
+	for(std::size_t i = Triangles.size() - 1; i > 0; --i)
+	{
+		Seed = Seed * 1103515245u + 12345u;
+		std::swap(Triangles[i], Triangles[(Seed >> 8) % (i + 1)]);
+	}
+
+	mesh Mesh;
+	for(triangle const& T : Triangles)
+	for(glm::vec2 const& V : T)
+	{
+		Mesh.Indices.push_back(static_cast<GLuint>(Mesh.Vertices.size()));
+		Mesh.Vertices.push_back(V);
+	}
+	return Mesh;
+}
+
+// Triangles by value, each rotated to start at its smallest vertex so that
+// winding is kept, then sorted
+static std::vector<triangle> triangle_set(glm::vec2 const* Vertices, GLuint const* Indices, std::size_t Count)
+{
+	auto Less = [](glm::vec2 const& A, glm::vec2 const& B) { return A.x < B.x || (A.x == B.x && A.y < B.y); };
+	std::vector<triangle> Set;
+	for(std::size_t i = 0; i < Count; i += 3)
+	{
+		triangle T = {{Vertices[Indices[i]], Vertices[Indices[i + 1]], Vertices[Indices[i + 2]]}};
+		std::rotate(T.begin(), std::min_element(T.begin(), T.end(), Less), T.end());
+		Set.push_back(T);
+	}
+	std::sort(Set.begin(), Set.end(), [&](triangle const& A, triangle const& B)
+	{
+		return std::lexicographical_compare(A.begin(), A.end(), B.begin(), B.end(), Less);
+	});
+	return Set;
+}
+
+static std::vector<triangle> optimized_set(mgl::MeshOptimizer const& Optimizer)
+{
+	std::vector<glm::vec2> Vertices(static_cast<std::size_t>(Optimizer.getVertexCount()));
+	std::memcpy(Vertices.data(), Optimizer.Vertices.data(), Vertices.size() * sizeof(glm::vec2));
+	return triangle_set(Vertices.data(), Optimizer.Indices.data(), Optimizer.Indices.size());
+}
+
+static int test_soup(int N)
+{
+	int Error = 0;
+
+	mesh const Mesh = make_soup(N);
+	mgl::MeshOptimizer Optimizer(Mesh.Vertices.data(), static_cast<GLsizei>(Mesh.Vertices.size()),
+		sizeof(glm::vec2), Mesh.Indices.data(), static_cast<GLsizei>(Mesh.Indices.size()));
+	float const Before = Optimizer.getACMR();
+
+	std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+	Optimizer.optimize();
+	std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+	float const After = Optimizer.getACMR();
+
+	std::printf("%d x %d grid soup: %d -> %d vertices, ACMR %.3f -> %.3f, %d us\n", N, N,
+		static_cast<int>(Mesh.Vertices.size()), Optimizer.getVertexCount(), Before, After,
+		static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count()));
+
+	// Every position is shared by its neighbours, welding leaves one vertex each
+	Error += Optimizer.getVertexCount() == (N + 1) * (N + 1) ? 0 : 1;
+	// A shuffled soup misses on every vertex, a grid can do much better than 1
+	Error += Before > 2.9f ? 0 : 1;
+	Error += After < 1.0f ? 0 : 1;
+	Error += Optimizer.getIndexCount() == static_cast<GLsizei>(Mesh.Indices.size()) ? 0 : 1;
+	Error += optimized_set(Optimizer) == triangle_set(Mesh.Vertices.data(), Mesh.Indices.data(), Mesh.Indices.size()) ? 0 : 1;
+
+	return Error;
+}
+
+// The tangram square, with 8 bit indices and nothing to weld
+static int test_square()
+{
+	int Error = 0;
+
+	std::vector<glm::vec2> const Vertices = {{-0.5f, -0.5f}, {0.5f, -0.5f}, {0.5f, 0.5f}, {-0.5f, 0.5f}};
+	std::vector<GLubyte> const Indices = {0, 1, 2, 0, 2, 3};
+	std::vector<GLuint> const Wide(Indices.begin(), Indices.end());
+
+	mgl::MeshOptimizer Optimizer(Vertices.data(), static_cast<GLsizei>(Vertices.size()), sizeof(glm::vec2),
+		Indices.data(), static_cast<GLsizei>(Indices.size()));
+	float const Before = Optimizer.getACMR();
+	Optimizer.optimize();
+
+	Error += Optimizer.getVertexCount() == 4 ? 0 : 1;
+	Error += Optimizer.getACMR() <= Before ? 0 : 1;
+	Error += optimized_set(Optimizer) == triangle_set(Vertices.data(), Wide.data(), Wide.size()) ? 0 : 1;
+
+	return Error;
+}
+
+int main()
+{
+	int Error = 0;
+
+	Error += test_square();
+	Error += test_soup(16);
+	Error += test_soup(256);
+
+	return Error;
+}
@@ -0,0 +1,184 @@
+#include <glm/ext/matrix_transform.hpp>
+#include "../../../mgl/mglPicking.hpp"
+#include <random>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+// The tangram triangle, square and parallelogram, as triangle lists
+struct shapes
+{
+	std::vector<glm::vec2> Vertices[3];
+};
+
+static shapes add_shapes(mgl::PickingIndex& Index)
+{
+	shapes Shapes;
+	Shapes.Vertices[0] = {{-0.5f, -0.5f}, {0.5f, -0.5f}, {-0.5f, 0.5f}};
+	Shapes.Vertices[1] = {{-0.5f, -0.5f}, {0.5f, -0.5f}, {0.5f, 0.5f}, {-0.5f, -0.5f}, {0.5f, 0.5f}, {-0.5f, 0.5f}};
+	Shapes.Vertices[2] = {{-1.0f, -0.5f}, {0.0f, -0.5f}, {1.0f, 0.5f}, {-1.0f, -0.5f}, {1.0f, 0.5f}, {0.0f, 0.5f}};
+	for(std::vector<glm::vec2> const& Vertices : Shapes.Vertices)
+		Index.addShape(Vertices.data(), static_cast<GLuint>(Vertices.size()));
+	return Shapes;
+}
+
+// Every triangle of every item, with the same arithmetic as the index, the last item containing the point winning
+static GLuint brute_force(shapes const& Shapes, std::vector<GLuint> const& Kinds, std::vector<glm::mat4> const& Matrices, glm::vec2 const& Point)
+{
+	for(std::size_t i = Matrices.size(); i-- > 0;)
+	{
+		glm::mat4 const& M = Matrices[i];
+		std::vector<glm::vec2> const& Vertices = Shapes.Vertices[Kinds[i]];
+		for(std::size_t v = 0; v < Vertices.size(); v += 3)
+		{
+			glm::vec2 P[3];
+			for(std::size_t k = 0; k < 3; ++k)
+				P[k] = glm::vec2(M[0]) * Vertices[v + k].x + glm::vec2(M[1]) * Vertices[v + k].y + glm::vec2(M[3]);
+			float const e0 = (P[1].x - P[0].x) * (Point.y - P[0].y) - (P[1].y - P[0].y) * (Point.x - P[0].x);
+			float const e1 = (P[2].x - P[1].x) * (Point.y - P[1].y) - (P[2].y - P[1].y) * (Point.x - P[1].x);
+			float const e2 = (P[0].x - P[2].x) * (Point.y - P[2].y) - (P[0].y - P[2].y) * (Point.x - P[2].x);
+			if((e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f) || (e0 <= 0.0f && e1 <= 0.0f && e2 <= 0.0f))
+				return static_cast<GLuint>(i);
+		}
+	}
+	return mgl::PickingIndex::NONE;
+}
+
+// Half of the points on an item, so most queries hit something, half anywhere on the board
+static std::vector<glm::vec2> make_points(std::vector<glm::mat4> const& Matrices, float Side, int Count, std::mt19937& Random)
+{
+	std::uniform_real_distribution<float> Uniform(-1.0f, 1.0f);
+	std::uniform_int_distribution<std::size_t> Item(0, Matrices.size() - 1);
+	std::vector<glm::vec2> Points;
+	for(int i = 0; i < Count; ++i)
+	{
+		if(i % 2 == 0)
+			Points.push_back(glm::vec2(Matrices[Item(Random)] * glm::vec4(Uniform(Random) * 0.3f, Uniform(Random) * 0.3f, 0.0f, 1.0f)));
+		else
+			Points.push_back(glm::vec2(Uniform(Random), Uniform(Random)) * Side);
+	}
+	return Points;
+}
+
+static int check(mgl::PickingIndex const& Index, shapes const& Shapes, std::vector<GLuint> const& Kinds, std::vector<glm::mat4> const& Matrices, std::vector<glm::vec2> const& Points, int Checks, double& Seconds)
+{
+	int Error = 0;
+	std::chrono::steady_clock::time_point const t1 = std::chrono::steady_clock::now();
+	for(int i = 0; i < Checks; ++i)
+		Error += Index.pick(Points[i]) == brute_force(Shapes, Kinds, Matrices, Points[i]) ? 0 : 1;
+	std::chrono::steady_clock::time_point const t2 = std::chrono::steady_clock::now();
+	Seconds = std::chrono::duration<double>(t2 - t1).count();
+	return Error;
+}
+
+static double time_picks(mgl::PickingIndex const& Index, std::vector<glm::vec2> const& Points, int& Hits)
+{
+	Hits = 0;
+	std::chrono::steady_clock::time_point const t1 = std::chrono::steady_clock::now();
+	for(glm::vec2 const& Point : Points)
+		Hits += Index.pick(Point) != mgl::PickingIndex::NONE ? 1 : 0;
+	std::chrono::steady_clock::time_point const t2 = std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(t2 - t1).count();
+}
+
+// Count pieces scattered at random over about one piece per unit square. Queries are timed and Checks of them are
+// compared with a brute force test of every item, once after the build and again after every Moves: each moves a
+// Moved share of the pieces a little, so their leaves are refitted, and sets some of them to the same matrix, so
+// the refit stops at the leaf.
+static int test_scattered(int Count, int Queries, int Checks, int Moves, float Moved)
+{
+	int Error = 0;
+
+	mgl::PickingIndex Index;
+	shapes const Shapes = add_shapes(Index);
+	std::mt19937 Random(1);
+	std::uniform_real_distribution<float> Uniform(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> Chance(0.0f, 1.0f);
+	float const Side = std::sqrt(static_cast<float>(Count));
+	std::vector<GLuint> Kinds;
+	std::vector<glm::mat4> Matrices;
+	for(int i = 0; i < Count; ++i)
+	{
+		glm::mat4 const M = glm::translate(glm::mat4(1.0f), glm::vec3(Uniform(Random), Uniform(Random), 0.0f) * Side);
+		Matrices.push_back(glm::rotate(M, Uniform(Random) * 3.14159f, glm::vec3(0.0f, 0.0f, 1.0f)));
+		Kinds.push_back(static_cast<GLuint>(i % 3));
+		Index.addItem(Kinds.back(), Matrices.back());
+	}
+
+	std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+	Index.update();
+	std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+	double const BuildSeconds = std::chrono::duration<double>(t2 - t1).count();
+
+	std::vector<glm::vec2> Points = make_points(Matrices, Side, Queries, Random);
+	int Hits = 0;
+	double const PickSeconds = time_picks(Index, Points, Hits);
+	double BruteSeconds = 0.0;
+	Error += check(Index, Shapes, Kinds, Matrices, Points, Checks, BruteSeconds);
+
+	double UpdateSeconds = 0.0;
+	for(int m = 0; m < Moves; ++m)
+	{
+		GLuint Expected = 0;
+		for(int i = 0; i < Count; ++i)
+		{
+			float const Roll = Chance(Random);
+			if(Roll < Moved)
+				Matrices[i] = glm::translate(Matrices[i], glm::vec3(Uniform(Random), Uniform(Random), 0.0f) * 0.25f);
+			else if(Roll > Moved * 2.0f)
+				continue;
+			Index.setMatrix(static_cast<GLuint>(i), Matrices[i]);
+			++Expected;
+		}
+		t1 = std::chrono::steady_clock::now();
+		Index.update();
+		t2 = std::chrono::steady_clock::now();
+		UpdateSeconds += std::chrono::duration<double>(t2 - t1).count();
+		Error += Index.Refitted == Expected ? 0 : 1;
+
+		Points = make_points(Matrices, Side, Checks, Random);
+		double Seconds = 0.0;
+		Error += check(Index, Shapes, Kinds, Matrices, Points, Checks, Seconds);
+	}
+
+	std::printf("%d pieces, SSE2: %d\n", Count, MGL_PICKING_SSE2);
+	std::printf("- build: %.3f ms, refit of %d%% of the pieces: %.3f ms\n",
+		BuildSeconds * 1000.0, static_cast<int>(Moved * 200.0f), Moves > 0 ? UpdateSeconds / Moves * 1000.0 : 0.0);
+	std::printf("- bounding volume hierarchy: %.3f us per pick, %d of %d picks hit\n",
+		PickSeconds / Queries * 1000000.0, Hits, Queries);
+	std::printf("- brute force: %.3f us per pick\n", BruteSeconds / Checks * 1000000.0);
+
+	// Half of the points are on a piece, the other half mostly are not
+	Error += Hits >= Queries / 2 && Hits < Queries ? 0 : 1;
+
+	return Error;
+}
+
+// Pieces stacked on the same spot: the one added last is picked
+static int test_stacked()
+{
+	int Error = 0;
+
+	mgl::PickingIndex Index;
+	add_shapes(Index);
+	for(GLuint i = 0; i < 10; ++i)
+		Index.addItem(i % 3, glm::mat4(1.0f));
+	Index.update();
+
+	Error += Index.pick(glm::vec2(-0.25f, -0.25f)) == 9 ? 0 : 1;
+	Error += Index.pick(glm::vec2(5.0f, 5.0f)) == mgl::PickingIndex::NONE ? 0 : 1;
+
+	return Error;
+}
+
+int main()
+{
+	int Error = 0;
+
+	Error += test_stacked();
+	Error += test_scattered(1000, 100000, 2000, 10, 0.1f);
+	Error += test_scattered(100000, 1000000, 200, 5, 0.01f);
+
+	return Error;
+}
@@ -0,0 +1,116 @@
+#define GLM_FORCE_INLINE
+#include <glm/ext/matrix_float4x4.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/ext/matrix_relational.hpp>
+#include <glm/ext/quaternion_float.hpp>
+#include <glm/ext/quaternion_trigonometric.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "../../../mgl/mglCompose.hpp"
+#include <vector>
+#include <chrono>
+#include <cstdio>
+
+struct trs
+{
+	std::vector<glm::vec3> T;
+	std::vector<glm::quat> R;
+	std::vector<glm::vec3> S;
+	std::vector<glm::vec2> T2;
+	std::vector<float> A;
+	std::vector<glm::vec2> S2;
+};
+
+static trs make_trs(std::size_t Samples)
+{
+	trs Input;
+	for(std::size_t i = 0; i < Samples; ++i)
+	{
+		float const f = static_cast<float>(i);
+		Input.T.push_back(glm::vec3(f * 0.01f, -f * 0.02f, 0.5f));
+		Input.R.push_back(glm::angleAxis(f * 0.1f, glm::normalize(glm::vec3(0.3f, 0.5f, 1.0f))));
+		Input.S.push_back(glm::vec3(0.5f + f * 0.001f, 1.0f, 2.0f));
+		Input.T2.push_back(glm::vec2(f * 0.01f, -f * 0.02f));
+		Input.A.push_back(f * 0.1f);
+		Input.S2.push_back(glm::vec2(0.5f + f * 0.001f, 1.0f));
+	}
+	return Input;
+}
+
+// As createTransformations() did: one identity based matrix and one product per component
+static void test_chained(trs const& I, std::vector<glm::mat4>& O)
+{
+	glm::mat4 const Identity(1.0f);
+	for(std::size_t i = 0, n = I.T.size(); i < n; ++i)
+	{
+		glm::mat4 M(1.0f);
+		M = glm::scale(Identity, I.S[i]) * M;
+		M = glm::mat4_cast(I.R[i]) * M;
+		M = glm::translate(Identity, I.T[i]) * M;
+		O[i] = M;
+	}
+}
+
+static void test_compose(trs const& I, std::vector<glm::mat4>& O)
+{
+	mgl::composeTRS(I.T.data(), I.R.data(), I.S.data(), O.data(), O.size());
+}
+
+static void test_chained_2d(trs const& I, std::vector<glm::mat4>& O)
+{
+	glm::mat4 const Identity(1.0f);
+	for(std::size_t i = 0, n = I.T2.size(); i < n; ++i)
+	{
+		glm::mat4 M(1.0f);
+		M = glm::scale(Identity, glm::vec3(I.S2[i], 1.0f)) * M;
+		M = glm::rotate(Identity, I.A[i], glm::vec3(0.0f, 0.0f, 1.0f)) * M;
+		M = glm::translate(Identity, glm::vec3(I.T2[i], 0.0f)) * M;
+		O[i] = M;
+	}
+}
+
+static void test_compose_2d(trs const& I, std::vector<glm::mat4>& O)
+{
+	mgl::composeTRS(I.T2.data(), I.A.data(), I.S2.data(), O.data(), O.size());
+}
+
+static int launch(void (*Test)(trs const&, std::vector<glm::mat4>&), trs const& I, std::vector<glm::mat4>& O)
+{
+	O.resize(I.T.size());
+
+	std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+	Test(I, O);
+	std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+
+	return static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count());
+}
+
+static int compare(std::vector<glm::mat4> const& A, std::vector<glm::mat4> const& B)
+{
+	int Error = 0;
+	for(std::size_t i = 0; i < A.size(); ++i)
+		Error += glm::all(glm::equal(A[i], B[i], 0.001f)) ? 0 : 1;
+	return Error;
+}
+
+int main()
+{
+	std::size_t const Samples = 100003; // not a multiple of the SIMD width
+
+	int Error = 0;
+
+	trs const Input = make_trs(Samples);
+	std::vector<glm::mat4> Chained;
+	std::vector<glm::mat4> Composed;
+
+	std::printf("TRS (quaternion) to mat4, SSE2: %d\n", MGL_COMPOSE_SSE2);
+	std::printf("- chained: %d us\n", launch(test_chained, Input, Chained));
+	std::printf("- compose: %d us\n", launch(test_compose, Input, Composed));
+	Error += compare(Chained, Composed);
+
+	std::printf("TRS (angle) to mat4, SSE2: %d\n", MGL_COMPOSE_SSE2);
+	std::printf("- chained: %d us\n", launch(test_chained_2d, Input, Chained));
+	std::printf("- compose: %d us\n", launch(test_compose_2d, Input, Composed));
+	Error += compare(Chained, Composed);
+
+	return Error;
+}
@@ -12,9 +12,27 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
-#include "./mglApp.hpp"         // IWYU pragma: keep
-#include "./mglConventions.hpp" // IWYU pragma: keep
-#include "./mglError.hpp"       // IWYU pragma: keep
-#include "./mglShader.hpp"      // IWYU pragma: keep
+#include "./mglApp.hpp"           // IWYU pragma: keep
+#include "./mglCapture.hpp"       // IWYU pragma: keep
+#include "./mglCollision.hpp"     // IWYU pragma: keep
+#include "./mglCommandBuffer.hpp" // IWYU pragma: keep
+#include "./mglCompose.hpp"       // IWYU pragma: keep
+#include "./mglConventions.hpp"   // IWYU pragma: keep
+#include "./mglError.hpp"         // IWYU pragma: keep
+#include "./mglIndirect.hpp"      // IWYU pragma: keep
+#include "./mglInput.hpp"         // IWYU pragma: keep
+#include "./mglMesh.hpp"          // IWYU pragma: keep
+#include "./mglMeshOptimizer.hpp" // IWYU pragma: keep
+#include "./mglPicking.hpp"       // IWYU pragma: keep
+#include "./mglProfiler.hpp"      // IWYU pragma: keep
+#include "./mglRenderQueue.hpp"   // IWYU pragma: keep
+#include "./mglResolution.hpp"    // IWYU pragma: keep
+#include "./mglScene.hpp"         // IWYU pragma: keep
+#include "./mglShader.hpp"        // IWYU pragma: keep
+#include "./mglState.hpp"         // IWYU pragma: keep
+#include "./mglTransform.hpp"     // IWYU pragma: keep
+#include "./mglUniformBuffer.hpp" // IWYU pragma: keep
+#include "./mglVertexLayout.hpp"  // IWYU pragma: keep
+#include "./mglWorkerPool.hpp"    // IWYU pragma: keep
 
 #endif /* MGL_HPP */
@@ -9,21 +9,75 @@
 #include "./mglApp.hpp"
 
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <chrono>
+#include <cmath>
 #include <iostream>
 #include <stdexcept>
-
-#include "./mglError.hpp" // IWYU pragma: keep -- required in debug mode
+#include <thread>
+#include <vector>
+
+#include "./mglCapture.hpp"
+#include "./mglError.hpp"
+#include "./mglProfiler.hpp"
+#include "./mglResolution.hpp"
+#include "./mglState.hpp"
+
+#ifdef __unix__
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/glx.h>
+#endif
 
 namespace mgl {
 
+// Bits of Engine::RedrawPending
+static const int REDRAW_DAMAGE = 1;
+static const int REDRAW_FULL = 2;
+
+// Grows rect, as x0, y0, x1, y1, to also cover other; empty ones are ignored
+static void unite(int *rect, const int *other) {
+  if (other[0] >= other[2] || other[1] >= other[3])
+    return;
+  if (rect[0] >= rect[2] || rect[1] >= rect[3]) {
+    std::copy(other, other + 4, rect);
+    return;
+  }
+  rect[0] = std::min(rect[0], other[0]);
+  rect[1] = std::min(rect[1], other[1]);
+  rect[2] = std::max(rect[2], other[2]);
+  rect[3] = std::max(rect[3], other[3]);
+}
+
 /////////////////////////////////////////////////////////////// STATIC CALLBACKS
 
+// Events are only queued here, the App receives them once per frame from
+// Engine::dispatchInput(), on the thread that renders
+
+static void queue_event(InputEventType type, int code, int scancode,
+                        int action, int mods, double x, double y) {
+  Engine::getInstance().queueInput(
+      {type, code, scancode, action, mods, x, y, glfwGetTime()});
+}
+
 static void window_close_callback(GLFWwindow *window) {
-  Engine::getInstance().getApp()->windowCloseCallback(window);
+  queue_event(InputEventType::WINDOW_CLOSE, 0, 0, 0, 0, 0.0, 0.0);
 }
 
 static void window_size_callback(GLFWwindow *window, int width, int height) {
-  Engine::getInstance().getApp()->windowSizeCallback(window, width, height);
+  queue_event(InputEventType::WINDOW_SIZE, 0, 0, 0, 0, width, height);
+}
+
+static void framebuffer_size_callback(GLFWwindow *window, int width,
+                                      int height) {
+  queue_event(InputEventType::FRAMEBUFFER_SIZE, 0, 0, 0, 0, width, height);
+}
+
+static void window_refresh_callback(GLFWwindow *window) {
+  Engine::getInstance().requestRedraw();
 }
 
 static void glfw_error_callback(int error, const char *description) {
@@ -31,36 +85,46 @@ static void glfw_error_callback(int error, const char *description) {
 }
 
 static void cursor_pos_callback(GLFWwindow *window, double xpos, double ypos) {
-  Engine::getInstance().getApp()->cursorCallback(window, xpos, ypos);
+  queue_event(InputEventType::CURSOR, 0, 0, 0, 0, xpos, ypos);
 }
 
 static void key_callback(GLFWwindow *window, int key, int scancode, int action,
                          int mods) {
-  Engine::getInstance().getApp()->keyCallback(window, key, scancode, action,
-                                              mods);
+  queue_event(InputEventType::KEY, key, scancode, action, mods, 0.0, 0.0);
 }
 
 static void mouse_button_callback(GLFWwindow *window, int button, int action,
                                   int mods) {
-  Engine::getInstance().getApp()->mouseButtonCallback(window, button, action,
-                                                      mods);
+  queue_event(InputEventType::MOUSE_BUTTON, button, 0, action, mods, 0.0, 0.0);
 }
 
 static void scroll_callback(GLFWwindow *window, double xoffset,
                             double yoffset) {
-  Engine::getInstance().getApp()->scrollCallback(window, xoffset, yoffset);
+  queue_event(InputEventType::SCROLL, 0, 0, 0, 0, xoffset, yoffset);
 }
 
 static void joystick_callback(int jid, int event) {
-  Engine::getInstance().getApp()->joystickCallback(jid, event);
+  queue_event(InputEventType::JOYSTICK, jid, 0, event, 0, 0.0, 0.0);
 }
 
 ////////////////////////////////////////////////////////////////////////// SETUP
 
+const int Engine::DAMAGE_HISTORY;
+
 Engine::Engine(void)
-    : WindowWidth(640), WindowHeight(480), GlApp(nullptr), Window(nullptr),
+    : WindowWidth(640), WindowHeight(480), FramebufferWidth(640),
+      FramebufferHeight(480), GlApp(nullptr), Window(nullptr),
       WindowTitle("OpenGL App GLFW Window 2025(c) Carlos Martinho"), GlMajor(3),
-      GlMinor(3), Fullscreen(0), Vsync(0) {}
+      GlMinor(3), Fullscreen(0), Vsync(0), Offscreen(0), FixedStep(0.0),
+      Accumulator(0.0), Alpha(1.0), Uncapped(0), OffscreenFrames(0),
+      Framebuffer(0), Renderbuffers{0, 0}, Profiling(0), Profiler(nullptr),
+      OnDemand(0), Partial(0), RedrawPending(REDRAW_FULL),
+      Damage{0, 0, 0, 0}, DamageHistory{}, DamageFrames(0), RenderedFrames(0),
+      PartialFrames(0), InputThread(0), WindowClosed(false),
+      OldestInput(-1.0), InputEvents(0), InputLatencySum(0.0),
+      InputLatencyMax(0.0), InputFrames(0), AsyncDebugOutput(0),
+      DebugRateLimit(0), Resolution(nullptr), CaptureEncoders(2),
+      CaptureDrop(0), Capture(nullptr) {}
 
 Engine::~Engine(void) {}
 
@@ -87,17 +151,143 @@ void Engine::setWindow(int width, int height, const char *title, int fullscreen,
   Vsync = vsync;
 }
 
+// Renders into an FBO of a hidden window for a fixed number of frames
+// (0 = until the stop predicate holds), dumping each frame to
+// <dump_prefix>NNNNN.ppm if a prefix is given.
+void Engine::setOffscreen(int frames, const char *dump_prefix) {
+  Offscreen = 1;
+  OffscreenFrames = frames;
+  DumpPrefix = dump_prefix ? dump_prefix : "";
+}
+
+void Engine::setStopPredicate(std::function<bool(int frame)> predicate) {
+  StopPredicate = predicate;
+}
+
+bool Engine::isOffscreen(void) { return Offscreen != 0; }
+
+// Calls App::updateCallback at a fixed rate of 1/step Hz, independently of
+// the display rate. Uncapped rendering ignores vsync. A step of 0 restores
+// the default loop.
+void Engine::setFixedTimestep(double step, int uncapped) {
+  FixedStep = step;
+  Uncapped = uncapped;
+}
+
+// How far the frame being displayed is between the last two fixed updates,
+// from 0 to 1, for displayCallback to interpolate; always 1 without them.
+double Engine::getAlpha(void) { return Alpha; }
+
+// Times every frame; a summary is printed at exit and, if a filename is
+// given, all frames are written to it as CSV (or JSON for .json files).
+void Engine::setProfiling(const char *dump_filename) {
+  Profiling = 1;
+  ProfileFilename = dump_filename ? dump_filename : "";
+}
+
+FrameProfiler *Engine::getProfiler(void) { return Profiler; }
+
+// GLFW only delivers events on the main thread, and only while it polls, so
+// events are timestamped once per frame at best. With an input thread, the
+// main thread does nothing but wait for events, timestamping each one as it
+// arrives, while rendering and every App callback run on a second thread
+// that owns the GL context. Apps must then not call GLFW functions that are
+// restricted to the main thread (the window and framebuffer sizes are kept
+// in WindowWidth, WindowHeight, FramebufferWidth and FramebufferHeight).
+void Engine::setInputThread(int input_thread) { InputThread = input_thread; }
+
+// In debug builds, reports GL debug messages from a background thread,
+// printing at most rate_limit messages per id and per second, instead of
+// synchronously from within the GL calls (see mglError.hpp)
+void Engine::setAsyncDebugOutput(unsigned int rate_limit) {
+  AsyncDebugOutput = 1;
+  DebugRateLimit = rate_limit;
+}
+
+// Renders every frame through the given scaler, which is not owned; nullptr
+// renders at the output size again. Partial redraws are not done meanwhile,
+// as damage is given in output pixels.
+void Engine::setDynamicResolution(DynamicResolution *resolution) {
+  Resolution = resolution;
+}
+
+// Saves every frame shown, through pixel buffer readbacks and encoder
+// threads: a path ending in .y4m records a video stream, any other path is
+// the prefix of numbered PNG files. With drop, frames are skipped rather than
+// waited for when the encoders fall behind.
+void Engine::setCapture(const char *path, unsigned int encoders, int drop) {
+  CapturePath = path;
+  CaptureEncoders = encoders;
+  CaptureDrop = drop;
+}
+
+// From the thread that receives GLFW events
+void Engine::queueInput(const InputEvent &event) {
+  Input.push(event);
+  if (InputThread) {
+    std::lock_guard<std::mutex> lock(WakeMutex);
+    Wake.notify_one();
+  }
+}
+
+// Wakes up the rendering thread if it waits for events or a redraw
+void Engine::wake(void) {
+  if (InputThread) {
+    std::lock_guard<std::mutex> lock(WakeMutex);
+    Wake.notify_one();
+  } else if (Window) {
+    glfwPostEmptyEvent();
+  }
+}
+
+// Renders only when something asked for it: between frames the loop blocks in
+// glfwWaitEvents() until requestRedraw() is called. Resizing or exposing the
+// window always redraws. With a fixed timestep, updateCallback keeps being
+// called on schedule while waiting, and requests a redraw when needed.
+//
+// Partial redraws clear and draw only the rectangles given to
+// requestRedraw(x, y, width, height), through the scissor test. They need to
+// know which frame the back buffer still holds: its age is queried every
+// frame with EGL_EXT_buffer_age or GLX_EXT_buffer_age, and the damage of the
+// frames since then is redrawn too. When the age is unknown (e.g. with WGL),
+// or older than the last DAMAGE_HISTORY frames, the whole frame is redrawn.
+// Offscreen runs ignore all of this and render every frame.
+void Engine::setOnDemand(int on_demand, int partial) {
+  OnDemand = on_demand;
+  Partial = partial;
+}
+
+bool Engine::isOnDemand(void) { return OnDemand && !Offscreen; }
+
+// Safe to call from any thread
+void Engine::requestRedraw(void) {
+  RedrawPending.fetch_or(REDRAW_FULL);
+  wake();
+}
+
+// Rectangle in framebuffer pixels with the origin at the bottom left, as for
+// glViewport; only from the thread that runs the engine
+void Engine::requestRedraw(int x, int y, int width, int height) {
+  if (width <= 0 || height <= 0)
+    return;
+  const int rect[4] = {x, y, x + width, y + height};
+  unite(Damage, rect);
+  RedrawPending.fetch_or(REDRAW_DAMAGE);
+}
+
 /////////////////////////////////////////////////////////////////////////// INIT
 
 void Engine::setupWindow() {
-  GLFWmonitor *monitor = Fullscreen ? glfwGetPrimaryMonitor() : nullptr;
+  GLFWmonitor *monitor =
+      Fullscreen && !Offscreen ? glfwGetPrimaryMonitor() : nullptr;
   Window = glfwCreateWindow(WindowWidth, WindowHeight, WindowTitle, monitor,
                             nullptr);
   if (!Window) {
     throw std::runtime_error("Failed to create GLFW window.");
   }
   glfwMakeContextCurrent(Window);
-  glfwSwapInterval(Vsync);
+  glfwSwapInterval(Offscreen || Uncapped ? 0 : Vsync);
+  glfwGetFramebufferSize(Window, &FramebufferWidth, &FramebufferHeight);
 }
 
 void Engine::setupCallbacks() {
@@ -108,10 +298,20 @@ void Engine::setupCallbacks() {
   glfwSetJoystickCallback(joystick_callback);
   glfwSetWindowCloseCallback(Window, window_close_callback);
   glfwSetWindowSizeCallback(Window, window_size_callback);
+  glfwSetWindowRefreshCallback(Window, window_refresh_callback);
+  glfwSetFramebufferSizeCallback(Window, framebuffer_size_callback);
 }
 
 void Engine::setupGLFW() {
   glfwSetErrorCallback(glfw_error_callback);
+#ifdef __linux__
+  // Without a display server, fall back to a surfaceless EGL context
+  const bool no_display = !std::getenv("DISPLAY") &&
+                          !std::getenv("WAYLAND_DISPLAY");
+  if (Offscreen && no_display) {
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+  }
+#endif
   if (!glfwInit()) {
     throw std::runtime_error("Failed to initialize GLFW.");
   }
@@ -120,6 +320,12 @@ void Engine::setupGLFW() {
 #ifdef DEBUG
   glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
 #endif
+  if (Offscreen) {
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    if (glfwGetPlatform() == GLFW_PLATFORM_NULL) {
+      glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+    }
+  }
   setupWindow();
   setupCallbacks();
 }
@@ -129,25 +335,68 @@ void Engine::setupGLEW() {
   // Allow extension entry points to be loaded even if the extension isn't
   // present in the driver's extensions string.
   GLenum result = glewInit();
-  if (result == GLEW_ERROR_NO_GLX_DISPLAY)
-    return; // Wayland does not have GLX
+  // Wayland and surfaceless EGL contexts have no GLX display. GLEW loads the
+  // GL entry points before it looks for GLX, so that error only matters if
+  // they are missing too.
+  if (result == GLEW_ERROR_NO_GLX_DISPLAY && glGenBuffers &&
+      glGenVertexArrays && glMapBufferRange && glFenceSync)
+    result = GLEW_OK;
   if (result != GLEW_OK) {
-    std::cerr << "ERROR glewInit: " << glewGetString(result) << std::endl;
+    std::cerr << "ERROR glewInit: " << glewGetErrorString(result) << std::endl;
     throw std::runtime_error("Failed to initialize GLEW.");
   }
 }
 
 void Engine::setupOpenGL() {
+  StateCache &state = StateCache::getInstance();
+  state.invalidate();
   glClearColor(0.1f, 0.1f, 0.3f, 1.0f);
-  glEnable(GL_DEPTH_TEST);
-  glDepthFunc(GL_LEQUAL);
-  glDepthMask(GL_TRUE);
+  state.enable(GL_DEPTH_TEST);
+  state.depthFunc(GL_LEQUAL);
+  state.depthMask(GL_TRUE);
   glDepthRange(0.0, 1.0);
   glClearDepth(1.0);
-  glEnable(GL_CULL_FACE);
-  glCullFace(GL_BACK);
+  state.enable(GL_CULL_FACE);
+  state.cullFace(GL_BACK);
   glFrontFace(GL_CCW);
-  glViewport(0, 0, WindowWidth, WindowHeight);
+  state.viewport(0, 0, WindowWidth, WindowHeight);
+  // Let the driver compile and link shaders on as many threads as it likes
+  if (GLEW_KHR_parallel_shader_compile)
+    glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+  else if (GLEW_ARB_parallel_shader_compile)
+    glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+}
+
+void Engine::setupOffscreen() {
+  FramebufferWidth = WindowWidth;
+  FramebufferHeight = WindowHeight;
+  glGenFramebuffers(1, &Framebuffer);
+  glGenRenderbuffers(2, Renderbuffers);
+  glBindRenderbuffer(GL_RENDERBUFFER, Renderbuffers[0]);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WindowWidth, WindowHeight);
+  glBindRenderbuffer(GL_RENDERBUFFER, Renderbuffers[1]);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, WindowWidth,
+                        WindowHeight);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  StateCache::getInstance().bindFramebuffer(GL_FRAMEBUFFER, Framebuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_RENDERBUFFER, Renderbuffers[0]);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+                            GL_RENDERBUFFER, Renderbuffers[1]);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    throw std::runtime_error("Failed to create offscreen framebuffer.");
+  }
+  // Stays bound for the whole run, so apps draw into it unchanged
+}
+
+void Engine::destroyOffscreen() {
+  StateCache &state = StateCache::getInstance();
+  state.bindFramebuffer(GL_FRAMEBUFFER, 0);
+  state.forgetFramebuffer(Framebuffer);
+  glDeleteFramebuffers(1, &Framebuffer);
+  glDeleteRenderbuffers(2, Renderbuffers);
+  Framebuffer = 0;
 }
 
 void displayInfo() {
@@ -164,33 +413,367 @@ void displayInfo() {
 void Engine::init() {
   setupGLFW();
   setupGLEW();
+  if (Offscreen)
+    setupOffscreen();
   setupOpenGL();
+  if (Profiling)
+    Profiler = new FrameProfiler(!ProfileFilename.empty());
+  if (!CapturePath.empty()) {
+    const size_t length = CapturePath.size();
+    const bool y4m =
+        length > 4 && CapturePath.compare(length - 4, 4, ".y4m") == 0;
+    Capture = new FrameCapture(
+        CapturePath, y4m ? FrameCapture::Y4M : FrameCapture::PNG,
+        CaptureEncoders, CaptureDrop ? FrameCapture::DROP : FrameCapture::WAIT);
+    if (FixedStep > 0.0)
+      Capture->FrameRate = static_cast<int>(std::lround(1.0 / FixedStep));
+  }
   GlApp->initCallback(Window);
 #ifdef DEBUG
   displayInfo();
-  setupDebugOutput();
+  if (AsyncDebugOutput)
+    setupAsyncDebugOutput(DebugRateLimit);
+  else
+    setupDebugOutput();
 #endif
 }
 
 //////////////////////////////////////////////////////////////////////////// RUN
 
-void Engine::run() {
-  double last_time = glfwGetTime();
+bool Engine::isDone(int frame) {
+  if (OffscreenFrames > 0 && frame >= OffscreenFrames)
+    return true;
+  return StopPredicate && StopPredicate(frame);
+}
+
+// Binary PPM, bottom-up rows flipped to top-down
+void Engine::dumpFrame(int frame) {
+  std::vector<GLubyte> pixels(WindowWidth * WindowHeight * 3);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, WindowWidth, WindowHeight, GL_RGB, GL_UNSIGNED_BYTE,
+               pixels.data());
+
+  char number[16];
+  std::snprintf(number, sizeof(number), "%05d", frame);
+  const std::string filename = DumpPrefix + number + ".ppm";
+  std::ofstream ofile(filename, std::ios::binary);
+  if (!ofile.is_open()) {
+    std::cerr << "[ERROR] Failed to open frame dump file: " << filename;
+    throw std::runtime_error("Failed to open frame dump file.");
+  }
+  ofile << "P6\n" << WindowWidth << " " << WindowHeight << "\n255\n";
+  const int row = WindowWidth * 3;
+  for (int y = WindowHeight - 1; y >= 0; y--) {
+    ofile.write(reinterpret_cast<const char *>(&pixels[y * row]), row);
+  }
+}
+
+void Engine::destroyProfiler() {
+  glFinish(); // so that the last GPU queries are available
+  Profiler->report(std::cout);
+  if (!ProfileFilename.empty())
+    Profiler->write(ProfileFilename);
+  delete Profiler;
+  Profiler = nullptr;
+}
+
+void Engine::destroyCapture() {
+  Capture->finish();
+  Capture->report(std::cout);
+  delete Capture;
+  Capture = nullptr;
+}
+
+// Consumes the elapsed time in fixed steps; at most a quarter of a second is
+// simulated per frame so a long stall cannot snowball into ever longer frames.
+double Engine::update(double elapsed_time) {
+  if (FixedStep <= 0.0)
+    return 1.0;
+  Accumulator += std::min(elapsed_time, 0.25);
+  while (Accumulator >= FixedStep) {
+    GlApp->updateCallback(Window, FixedStep);
+    Accumulator -= FixedStep;
+  }
+  return Accumulator / FixedStep;
+}
+
+// Hands the queued events to the App in one batch. Nothing is delivered after
+// the window close event, as the App may have released its resources.
+void Engine::dispatchInput() {
+  Input.drain(InputBatch);
+  for (const InputEvent &e : InputBatch) {
+    if (WindowClosed)
+      break;
+    InputEvents++;
+    if (OldestInput < 0.0 || e.time < OldestInput)
+      OldestInput = e.time;
+    switch (e.type) {
+    case InputEventType::CURSOR:
+      GlApp->cursorCallback(Window, e.x, e.y);
+      break;
+    case InputEventType::KEY:
+      GlApp->keyCallback(Window, e.code, e.scancode, e.action, e.mods);
+      break;
+    case InputEventType::MOUSE_BUTTON:
+      GlApp->mouseButtonCallback(Window, e.code, e.action, e.mods);
+      break;
+    case InputEventType::SCROLL:
+      GlApp->scrollCallback(Window, e.x, e.y);
+      break;
+    case InputEventType::JOYSTICK:
+      GlApp->joystickCallback(e.code, e.action);
+      break;
+    case InputEventType::WINDOW_SIZE:
+      WindowWidth = static_cast<int>(e.x);
+      WindowHeight = static_cast<int>(e.y);
+      requestRedraw();
+      GlApp->windowSizeCallback(Window, WindowWidth, WindowHeight);
+      break;
+    case InputEventType::FRAMEBUFFER_SIZE:
+      FramebufferWidth = static_cast<int>(e.x);
+      FramebufferHeight = static_cast<int>(e.y);
+      requestRedraw();
+      break;
+    case InputEventType::WINDOW_CLOSE:
+      WindowClosed = true;
+      GlApp->windowCloseCallback(Window);
+      break;
+    }
+  }
+}
+
+// Waits for events, a redraw request or the timeout (none if negative), then
+// dispatches whatever events arrived
+void Engine::waitEvents(double timeout) {
+  if (InputThread) {
+    std::unique_lock<std::mutex> lock(WakeMutex);
+    auto ready = [this]() {
+      return RedrawPending.load() || !Input.empty() ||
+             glfwWindowShouldClose(Window);
+    };
+    if (timeout < 0.0)
+      Wake.wait(lock, ready);
+    else
+      Wake.wait_for(lock, std::chrono::duration<double>(timeout), ready);
+  } else if (timeout < 0.0) {
+    glfwWaitEvents();
+  } else {
+    glfwWaitEventsTimeout(timeout);
+  }
+  dispatchInput();
+}
+
+// Blocks until a redraw is requested or the window should close. Fixed steps
+// that fall due meanwhile are run, waking up just in time for each of them;
+// last_update is when the time consumed by update() was last measured.
+void Engine::waitForRedraw(double &last_update) {
+  while (!RedrawPending.load() && !glfwWindowShouldClose(Window)) {
+    if (FixedStep > 0.0) {
+      waitEvents(std::max(FixedStep - Accumulator, 0.001));
+      const double time = glfwGetTime();
+      update(time - last_update);
+      last_update = time;
+    } else {
+      waitEvents(-1.0);
+    }
+  }
+}
+
+// Number of swaps since the back buffer of the current context was last
+// presented, 1 for the previous frame, or 0 if its contents are unknown
+static int queryBufferAge() {
+#ifdef __unix__
+  if (eglGetCurrentContext() != EGL_NO_CONTEXT) {
+    EGLint age = 0;
+    if (glfwExtensionSupported("EGL_EXT_buffer_age") &&
+        eglQuerySurface(eglGetCurrentDisplay(), eglGetCurrentSurface(EGL_DRAW),
+                        EGL_BUFFER_AGE_EXT, &age))
+      return age;
+  } else if (glXGetCurrentContext() &&
+             glfwExtensionSupported("GLX_EXT_buffer_age")) {
+    unsigned int age = 0;
+    glXQueryDrawable(glXGetCurrentDisplay(), glXGetCurrentDrawable(),
+                     GLX_BACK_BUFFER_AGE_EXT, &age);
+    return static_cast<int>(age);
+  }
+#endif
+  return 0;
+}
+
+// Takes the pending requests and, for a partial redraw, limits clearing and
+// drawing to the damage of this frame and of the frames the back buffer
+// missed. Returns whether the scissor test was enabled.
+bool Engine::beginRedraw() {
+  const int pending = RedrawPending.exchange(0);
+  const int width = FramebufferWidth, height = FramebufferHeight;
+  int rect[4] = {Damage[0], Damage[1], Damage[2], Damage[3]};
+  Damage[0] = Damage[1] = Damage[2] = Damage[3] = 0;
+  RenderedFrames++;
+  const int age = Partial && !Resolution ? queryBufferAge() : 0;
+  const bool full = !Partial || Resolution || (pending & REDRAW_FULL) ||
+                    age <= 0 || age - 1 > DamageFrames;
+  if (full) {
+    rect[0] = rect[1] = 0;
+    rect[2] = width;
+    rect[3] = height;
+  }
+  const int damage[4] = {rect[0], rect[1], rect[2], rect[3]};
+  for (int i = 0; !full && i < age - 1; i++)
+    unite(rect, DamageHistory[i]);
+  for (int i = DAMAGE_HISTORY - 1; i > 0; i--)
+    std::copy(DamageHistory[i - 1], DamageHistory[i - 1] + 4, DamageHistory[i]);
+  std::copy(damage, damage + 4, DamageHistory[0]);
+  DamageFrames = std::min(DamageFrames + 1, DAMAGE_HISTORY);
+  if (full)
+    return false;
+  rect[0] = std::max(rect[0], 0);
+  rect[1] = std::max(rect[1], 0);
+  rect[2] = std::min(rect[2], width);
+  rect[3] = std::min(rect[3], height);
+  if (rect[0] == 0 && rect[1] == 0 && rect[2] == width && rect[3] == height)
+    return false;
+  StateCache &state = StateCache::getInstance();
+  state.enable(GL_SCISSOR_TEST);
+  state.scissor(rect[0], rect[1], std::max(rect[2] - rect[0], 0),
+                std::max(rect[3] - rect[1], 0));
+  PartialFrames++;
+  return true;
+}
+
+// Time from the oldest event dispatched before a frame to its swap
+void Engine::measureInputLatency() {
+  if (OldestInput < 0.0)
+    return;
+  const double latency = glfwGetTime() - OldestInput;
+  InputLatencySum += latency;
+  InputLatencyMax = std::max(InputLatencyMax, latency);
+  InputFrames++;
+  OldestInput = -1.0;
+}
+
+void Engine::renderLoop() {
+  int frame = 0;
+  double start_time = glfwGetTime();
+  double last_time = start_time;
+  double last_update = start_time;
+  Accumulator = 0.0;
+  const bool on_demand = isOnDemand();
   while (!glfwWindowShouldClose(Window)) {
     try {
+      if (on_demand) {
+        waitForRedraw(last_update);
+        if (glfwWindowShouldClose(Window))
+          break;
+      }
       double time = glfwGetTime();
       double elapsed_time = time - last_time;
-      last_time = time;
+      double update_time = time - last_update;
+      last_time = last_update = time;
+      // Offscreen runs advance exactly one step per frame, so they replay
+      // identically regardless of how fast frames are rendered
+      if (Offscreen && FixedStep > 0.0)
+        elapsed_time = update_time = FixedStep;
+      if (Profiler)
+        Profiler->beginFrame();
+      Alpha = update(update_time);
+      if (Profiler)
+        Profiler->mark(FrameProfiler::UPDATE);
+      const bool scissor = on_demand && beginRedraw();
+      if (Resolution)
+        Resolution->begin(FramebufferWidth, FramebufferHeight);
       glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT |
               GL_STENCIL_BUFFER_BIT);
+      if (Profiler)
+        Profiler->mark(FrameProfiler::CLEAR);
       GlApp->displayCallback(Window, elapsed_time);
+      if (scissor)
+        StateCache::getInstance().disable(GL_SCISSOR_TEST);
+      if (Resolution)
+        Resolution->end(Offscreen ? Framebuffer : 0);
+      if (Offscreen && !DumpPrefix.empty())
+        dumpFrame(frame);
+      if (Profiler) {
+        Profiler->mark(FrameProfiler::DISPLAY);
+        Profiler->endGpu();
+      }
+      if (Capture)
+        Capture->capture(Offscreen ? Framebuffer : 0, FramebufferWidth,
+                         FramebufferHeight);
       glfwSwapBuffers(Window);
-      glfwPollEvents();
+      measureInputLatency();
+      if (Profiler)
+        Profiler->mark(FrameProfiler::SWAP);
+      if (!InputThread)
+        glfwPollEvents();
+      dispatchInput();
+      if (Profiler) {
+        Profiler->mark(FrameProfiler::EVENTS);
+        Profiler->endFrame();
+      }
+      StateCache::getInstance().endFrame();
+      frame++;
+      if (Offscreen && isDone(frame)) {
+        WindowClosed = true;
+        GlApp->windowCloseCallback(Window);
+        glfwSetWindowShouldClose(Window, GLFW_TRUE);
+      }
     } catch (const std::exception &e) {
       std::cerr << "FRAME EXCEPTION: " << e.what() << std::endl;
       glfwSetWindowShouldClose(Window, GLFW_TRUE);
     }
   }
+  dispatchInput(); // the close event may have arrived after the last frame
+  // The loop also ends on a frame exception, and the close event may have
+  // been dropped: the App still gets to release its resources
+  if (!WindowClosed) {
+    WindowClosed = true;
+    GlApp->windowCloseCallback(Window);
+  }
+  if (Offscreen) {
+    glFinish();
+    double total = glfwGetTime() - start_time;
+    std::cout << "Offscreen: " << frame << " frames in " << total << " s ("
+              << (frame ? total * 1000.0 / frame : 0.0) << " ms/frame)"
+              << std::endl;
+    destroyOffscreen();
+  }
+  if (on_demand) {
+    std::cout << "On demand: " << RenderedFrames << " frames ("
+              << PartialFrames << " partial) in " << glfwGetTime() - start_time
+              << " s" << std::endl;
+  }
+  if (InputFrames > 0) {
+    std::cout << "Input: " << InputEvents << " events ("
+              << Input.Coalesced << " coalesced, " << Input.Dropped.load()
+              << " dropped), latency to swap "
+              << InputLatencySum * 1000.0 / InputFrames << " ms average, "
+              << InputLatencyMax * 1000.0 << " ms max" << std::endl;
+  }
+  if (Capture)
+    destroyCapture();
+  if (Profiler)
+    destroyProfiler();
+  stopDebugOutput();
+}
+
+void Engine::run() {
+  if (InputThread && !Offscreen) {
+    std::atomic<bool> done(false);
+    glfwMakeContextCurrent(nullptr);
+    std::thread renderer([this, &done]() {
+      glfwMakeContextCurrent(Window);
+      renderLoop();
+      glfwMakeContextCurrent(nullptr);
+      done = true;
+      glfwPostEmptyEvent();
+    });
+    while (!done)
+      glfwWaitEvents();
+    renderer.join();
+    glfwMakeContextCurrent(Window);
+  } else {
+    renderLoop();
+  }
   glfwDestroyWindow(Window);
   Window = nullptr;
   glfwTerminate();
@@ -11,19 +11,31 @@
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <glm/ext.hpp>
 #include <glm/glm.hpp>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "./mglInput.hpp"
 
 namespace mgl {
 
 class App;
 class Engine;
+class FrameProfiler;
+class DynamicResolution;
+class FrameCapture;
 
 //////////////////////////////////////////////////////////////////////////// App
 
 class App {
 public:
   virtual void initCallback(GLFWwindow *window) {}
+  virtual void updateCallback(GLFWwindow *window, double step) {}
   virtual void displayCallback(GLFWwindow *window, double elapsed) {}
   virtual void windowCloseCallback(GLFWwindow *window) {}
   virtual void windowSizeCallback(GLFWwindow *window, int width, int height) {}
@@ -45,6 +57,7 @@ protected:
 class Engine {
 public:
   int WindowWidth, WindowHeight;
+  int FramebufferWidth, FramebufferHeight;
 
   static Engine &getInstance();
 
@@ -53,6 +66,22 @@ public:
   void setOpenGL(int major, int minor);
   void setWindow(int width, int height, const char *title, int fullscreen,
                  int vsync);
+  void setOffscreen(int frames, const char *dump_prefix = nullptr);
+  void setStopPredicate(std::function<bool(int frame)> predicate);
+  bool isOffscreen();
+  void setFixedTimestep(double step, int uncapped = 0);
+  double getAlpha();
+  void setProfiling(const char *dump_filename = nullptr);
+  FrameProfiler *getProfiler();
+  void setOnDemand(int on_demand, int partial = 0);
+  bool isOnDemand();
+  void requestRedraw();
+  void requestRedraw(int x, int y, int width, int height);
+  void setInputThread(int input_thread);
+  void queueInput(const InputEvent &event);
+  void setAsyncDebugOutput(unsigned int rate_limit = 10);
+  void setDynamicResolution(DynamicResolution *resolution);
+  void setCapture(const char *path, unsigned int encoders = 2, int drop = 0);
   void init();
   void run();
 
@@ -67,12 +96,63 @@ private:
   int GlMajor, GlMinor;
   int Fullscreen;
   int Vsync;
+  int Offscreen;
+  double FixedStep;
+  double Accumulator;
+  double Alpha;
+  int Uncapped;
+  int OffscreenFrames;
+  std::string DumpPrefix;
+  std::function<bool(int frame)> StopPredicate;
+  GLuint Framebuffer, Renderbuffers[2];
+  int Profiling;
+  std::string ProfileFilename;
+  FrameProfiler *Profiler;
+  int OnDemand;
+  int Partial;
+  std::atomic<int> RedrawPending;
+  static const int DAMAGE_HISTORY = 4;
+  int Damage[4]; // x0, y0, x1, y1 in framebuffer pixels
+  int DamageHistory[DAMAGE_HISTORY][4]; // of the frames before, newest first
+  int DamageFrames;                     // valid entries in DamageHistory
+  int RenderedFrames, PartialFrames;
+  int InputThread;
+  InputQueue Input;
+  std::vector<InputEvent> InputBatch;
+  bool WindowClosed;
+  std::mutex WakeMutex;
+  std::condition_variable Wake;
+  double OldestInput; // time of the oldest event dispatched since the swap
+  GLuint InputEvents;
+  double InputLatencySum, InputLatencyMax;
+  GLuint InputFrames;
+  int AsyncDebugOutput;
+  unsigned int DebugRateLimit;
+  DynamicResolution *Resolution;
+  std::string CapturePath;
+  unsigned int CaptureEncoders;
+  int CaptureDrop;
+  FrameCapture *Capture;
 
   void setupWindow();
   void setupGLFW();
   void setupGLEW();
   void setupOpenGL();
   void setupCallbacks();
+  void setupOffscreen();
+  void destroyOffscreen();
+  bool isDone(int frame);
+  double update(double elapsed_time);
+  void dumpFrame(int frame);
+  void destroyProfiler();
+  void destroyCapture();
+  void wake();
+  void dispatchInput();
+  void waitEvents(double timeout);
+  void waitForRedraw(double &last_update);
+  bool beginRedraw();
+  void measureInputLatency();
+  void renderLoop();
 
 public:
   Engine(Engine const &) = delete;
@@ -0,0 +1,518 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Frame Capture Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglCapture.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+#include "./mglState.hpp"
+
+namespace mgl {
+
+///////////////////////////////////////////////////////////////////// ZLIB / PNG
+//
+// Deflate with the fixed Huffman codes and greedy LZ77 matches found through
+// a hash table of the last position of every 3 byte sequence. The ratio is
+// far from zlib's best, but rendered frames are mostly flat colour, which it
+// compresses well, and it is fast enough to keep up on a couple of threads.
+
+static const size_t DEFLATE_WINDOW = 32768;
+static const size_t DEFLATE_MAX_MATCH = 258;
+static const int DEFLATE_HASH_BITS = 15;
+
+static const uint16_t LENGTH_BASE[29] = {
+    3,  4,  5,  6,  7,  8,  9,  10,  11,  13,  15,  17,  19,  23, 27,
+    31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t LENGTH_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+    2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t DISTANCE_BASE[30] = {
+    1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+    33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+    1025, 1537, 2049, 3073, 4097, 6145,  8193,  12289, 16385, 24577};
+static const uint8_t DISTANCE_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+    6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+class BitWriter {
+public:
+  explicit BitWriter(std::vector<GLubyte> &out) : Out(out), Bits(0), Count(0) {}
+
+  // Plain values are written least significant bit first
+  void put(const uint32_t value, const unsigned int count) {
+    Bits |= value << Count;
+    Count += count;
+    while (Count >= 8) {
+      Out.push_back(static_cast<GLubyte>(Bits));
+      Bits >>= 8;
+      Count -= 8;
+    }
+  }
+
+  // Huffman codes most significant bit first
+  void putCode(uint32_t code, const unsigned int length) {
+    uint32_t reversed = 0;
+    for (unsigned int i = 0; i < length; i++, code >>= 1)
+      reversed = (reversed << 1) | (code & 1);
+    put(reversed, length);
+  }
+
+  void flush() {
+    if (Count > 0)
+      Out.push_back(static_cast<GLubyte>(Bits));
+    Bits = 0;
+    Count = 0;
+  }
+
+private:
+  std::vector<GLubyte> &Out;
+  uint32_t Bits;
+  unsigned int Count;
+};
+
+static void putSymbol(BitWriter &out, const unsigned int symbol) {
+  if (symbol < 144)
+    out.putCode(0x30 + symbol, 8);
+  else if (symbol < 256)
+    out.putCode(0x190 + symbol - 144, 9);
+  else if (symbol < 280)
+    out.putCode(symbol - 256, 7);
+  else
+    out.putCode(0xC0 + symbol - 280, 8);
+}
+
+static void putMatch(BitWriter &out, const unsigned int length,
+                     const unsigned int distance) {
+  int l = 28;
+  while (LENGTH_BASE[l] > length)
+    l--;
+  putSymbol(out, 257 + l);
+  out.put(length - LENGTH_BASE[l], LENGTH_EXTRA[l]);
+  int d = 29;
+  while (DISTANCE_BASE[d] > distance)
+    d--;
+  out.putCode(d, 5);
+  out.put(distance - DISTANCE_BASE[d], DISTANCE_EXTRA[d]);
+}
+
+static uint32_t hash3(const GLubyte *p) {
+  const uint32_t key = p[0] | (p[1] << 8) | (p[2] << 16);
+  return (key * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+}
+
+static void deflate(const GLubyte *data, const size_t size,
+                    std::vector<GLubyte> &out) {
+  std::vector<int64_t> last(size_t(1) << DEFLATE_HASH_BITS, -1);
+  BitWriter bits(out);
+  bits.put(1, 1); // final block
+  bits.put(1, 2); // fixed codes
+  size_t i = 0;
+  while (i < size) {
+    size_t length = 0, distance = 0;
+    if (i + 3 <= size) {
+      const uint32_t h = hash3(data + i);
+      const int64_t candidate = last[h];
+      last[h] = static_cast<int64_t>(i);
+      if (candidate >= 0 && i - candidate <= DEFLATE_WINDOW) {
+        const size_t limit = std::min(DEFLATE_MAX_MATCH, size - i);
+        size_t n = 0;
+        while (n < limit && data[candidate + n] == data[i + n])
+          n++;
+        if (n >= 3) {
+          length = n;
+          distance = i - candidate;
+        }
+      }
+    }
+    if (length == 0) {
+      putSymbol(bits, data[i++]);
+      continue;
+    }
+    putMatch(bits, static_cast<unsigned int>(length),
+             static_cast<unsigned int>(distance));
+    for (size_t j = i + 1; j < i + length && j + 3 <= size; j++)
+      last[hash3(data + j)] = static_cast<int64_t>(j);
+    i += length;
+  }
+  putSymbol(bits, 256); // end of block
+  bits.flush();
+}
+
+static uint32_t adler32(const GLubyte *data, const size_t size) {
+  uint32_t a = 1, b = 0;
+  for (size_t i = 0; i < size;) {
+    const size_t end = std::min(size, i + 5552); // before b can overflow
+    for (; i < end; i++) {
+      a += data[i];
+      b += a;
+    }
+    a %= 65521;
+    b %= 65521;
+  }
+  return (b << 16) | a;
+}
+
+static uint32_t crc32(const GLubyte *data, const size_t size) {
+  static const struct Table {
+    uint32_t entries[256];
+    Table() {
+      for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++)
+          c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        entries[n] = c;
+      }
+    }
+  } table;
+  uint32_t crc = 0xFFFFFFFFu;
+  for (size_t i = 0; i < size; i++)
+    crc = table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return crc ^ 0xFFFFFFFFu;
+}
+
+static void putBigEndian(std::vector<GLubyte> &out, const uint32_t value) {
+  out.push_back(static_cast<GLubyte>(value >> 24));
+  out.push_back(static_cast<GLubyte>(value >> 16));
+  out.push_back(static_cast<GLubyte>(value >> 8));
+  out.push_back(static_cast<GLubyte>(value));
+}
+
+// Returns where the chunk starts, its length is filled in by endChunk()
+static size_t beginChunk(std::vector<GLubyte> &png, const char *type) {
+  const size_t start = png.size();
+  putBigEndian(png, 0);
+  png.insert(png.end(), type, type + 4);
+  return start;
+}
+
+static void endChunk(std::vector<GLubyte> &png, const size_t start) {
+  const uint32_t length = static_cast<uint32_t>(png.size() - start - 8);
+  for (int i = 0; i < 4; i++)
+    png[start + i] = static_cast<GLubyte>(length >> (24 - 8 * i));
+  putBigEndian(png, crc32(&png[start + 4], length + 4));
+}
+
+/////////////////////////////////////////////////////////////////// FrameCapture
+
+const int FrameCapture::SLOTS;
+
+FrameCapture::FrameCapture(const std::string &path, const Format format,
+                           const unsigned int encoders, const Policy policy,
+                           const unsigned int max_queued)
+    : Output(format), Behind(policy), FrameRate(60), Captured(0), Written(0),
+      Dropped(0), Stalls(0), Waits(0), CpuMsSum(0.0), CpuMsMax(0.0),
+      Path(path), SlotNext(0), StreamWidth(0), StreamHeight(0), Sequence(0),
+      Calls(0), Finished(false), MaxQueued(std::max(1u, max_queued)),
+      NextWrite(0), Quit(false) {
+  if (Output == Y4M) {
+    Stream.open(Path, std::ios::binary);
+    if (!Stream.is_open()) {
+      std::cerr << "[ERROR] Failed to open capture file: " << Path
+                << std::endl;
+      throw std::runtime_error("Failed to open capture file.");
+    }
+  }
+  for (Slot &slot : Slots) {
+    slot = {0, nullptr, 0, 0, 0, 0};
+    glGenBuffers(1, &slot.buffer);
+  }
+  for (unsigned int i = 0; i < std::max(1u, encoders); i++)
+    Encoders.emplace_back(&FrameCapture::encode, this);
+}
+
+FrameCapture::~FrameCapture() { finish(); }
+
+bool FrameCapture::signalled(const Slot &slot, const bool wait) {
+  GLenum status;
+  do {
+    status = glClientWaitSync(slot.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+                              wait ? 1000000000 : 0);
+  } while (wait && status == GL_TIMEOUT_EXPIRED);
+  return status != GL_TIMEOUT_EXPIRED; // a failed wait is left to the map
+}
+
+// Readbacks complete in the order they were started, so collection stops at
+// the first one still in flight
+void FrameCapture::collect(const bool wait) {
+  for (int i = 0; i < SLOTS; i++) {
+    Slot &slot = Slots[(SlotNext + i) % SLOTS];
+    if (!slot.fence)
+      continue;
+    if (!signalled(slot, wait))
+      return;
+    readback(slot);
+  }
+}
+
+void FrameCapture::readback(Slot &slot) {
+  glDeleteSync(slot.fence);
+  slot.fence = nullptr;
+  Frame *frame = acquire();
+  if (!frame) {
+    Dropped++;
+    return;
+  }
+  StateCache &state = StateCache::getInstance();
+  state.bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+  const GLubyte *pixels = static_cast<const GLubyte *>(
+      glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.size, GL_MAP_READ_BIT));
+  if (pixels) {
+    frame->pixels.assign(pixels, pixels + slot.size);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  state.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  std::unique_lock<std::mutex> lock(Mutex);
+  if (!pixels) {
+    Free.push_back(frame);
+    Dropped++;
+    return;
+  }
+  frame->width = slot.width;
+  frame->height = slot.height;
+  frame->number = slot.number;
+  frame->sequence = Sequence++;
+  Queue.push_back(frame);
+  lock.unlock();
+  Ready.notify_one();
+}
+
+// Back-pressure: nullptr under DROP when every frame is queued or encoding
+FrameCapture::Frame *FrameCapture::acquire() {
+  std::unique_lock<std::mutex> lock(Mutex);
+  if (Free.empty()) {
+    if (Frames.size() < MaxQueued) {
+      Frames.emplace_back(new Frame());
+      return Frames.back().get();
+    }
+    if (Behind == DROP)
+      return nullptr;
+    Waits++;
+    Done.wait(lock, [this] { return !Free.empty(); });
+  }
+  Frame *frame = Free.back();
+  Free.pop_back();
+  return frame;
+}
+
+void FrameCapture::capture(const GLuint framebuffer, const GLsizei width,
+                           const GLsizei height) {
+  if (Finished || width <= 0 || height <= 0)
+    return;
+  const auto start = std::chrono::steady_clock::now();
+  Calls++;
+  collect(false);
+  Slot &slot = Slots[SlotNext];
+  if (slot.fence) {
+    Stalls++;
+    signalled(slot, true);
+    readback(slot);
+  }
+  if (Output == Y4M && StreamWidth == 0) {
+    StreamWidth = width;
+    StreamHeight = height;
+  }
+  if (Output == Y4M && (width != StreamWidth || height != StreamHeight)) {
+    Dropped++;
+  } else {
+    const GLsizeiptr size = static_cast<GLsizeiptr>(width) * height * 4;
+    StateCache &state = StateCache::getInstance();
+    state.bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    if (slot.size != size) {
+      glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+      slot.size = size;
+    }
+    state.bindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    state.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.width = width;
+    slot.height = height;
+    slot.number = Captured++;
+    SlotNext = (SlotNext + 1) % SLOTS;
+  }
+  const double ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+  CpuMsSum += ms;
+  CpuMsMax = std::max(CpuMsMax, ms);
+}
+
+void FrameCapture::finish() {
+  if (Finished)
+    return;
+  Finished = true;
+  collect(true);
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    Quit = true;
+  }
+  Ready.notify_all();
+  for (std::thread &encoder : Encoders)
+    encoder.join();
+  Encoders.clear();
+  if (Stream.is_open())
+    Stream.close();
+  for (Slot &slot : Slots) {
+    StateCache::getInstance().forgetBuffer(slot.buffer);
+    glDeleteBuffers(1, &slot.buffer);
+    slot.buffer = 0;
+  }
+}
+
+// Encoder threads: the queue is emptied before quitting
+void FrameCapture::encode() {
+  std::vector<GLubyte> raw, packed;
+  for (;;) {
+    Frame *frame;
+    {
+      std::unique_lock<std::mutex> lock(Mutex);
+      Ready.wait(lock, [this] { return Quit || !Queue.empty(); });
+      if (Queue.empty())
+        return;
+      frame = Queue.front();
+      Queue.pop_front();
+    }
+    const bool written = Output == PNG ? writePng(*frame, raw, packed)
+                                       : writeY4m(*frame, raw);
+    {
+      std::lock_guard<std::mutex> lock(Mutex);
+      Free.push_back(frame);
+      if (written)
+        Written++;
+    }
+    Done.notify_one();
+  }
+}
+
+// RGB without alpha, rows flipped to top-down, no filtering
+bool FrameCapture::writePng(const Frame &frame, std::vector<GLubyte> &raw,
+                            std::vector<GLubyte> &png) {
+  const size_t width = frame.width, height = frame.height;
+  const size_t row = 1 + width * 3;
+  raw.resize(row * height);
+  for (size_t y = 0; y < height; y++) {
+    GLubyte *out = &raw[y * row];
+    const GLubyte *in = &frame.pixels[(height - 1 - y) * width * 4];
+    *out++ = 0;
+    for (size_t x = 0; x < width; x++, in += 4, out += 3) {
+      out[0] = in[0];
+      out[1] = in[1];
+      out[2] = in[2];
+    }
+  }
+
+  static const GLubyte SIGNATURE[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+  png.assign(SIGNATURE, SIGNATURE + 8);
+  size_t chunk = beginChunk(png, "IHDR");
+  putBigEndian(png, static_cast<uint32_t>(width));
+  putBigEndian(png, static_cast<uint32_t>(height));
+  png.insert(png.end(), {8, 2, 0, 0, 0}); // 8 bit RGB
+  endChunk(png, chunk);
+  chunk = beginChunk(png, "IDAT");
+  png.push_back(0x78); // deflate, 32K window
+  png.push_back(0x01);
+  deflate(raw.data(), raw.size(), png);
+  putBigEndian(png, adler32(raw.data(), raw.size()));
+  endChunk(png, chunk);
+  endChunk(png, beginChunk(png, "IEND"));
+
+  char number[16];
+  std::snprintf(number, sizeof(number), "%05u", frame.number);
+  const std::string filename = Path + number + ".png";
+  std::ofstream file(filename, std::ios::binary);
+  if (!file.is_open()) {
+    std::cerr << "[ERROR] Failed to open capture file: " << filename
+              << std::endl;
+    return false;
+  }
+  file.write(reinterpret_cast<const char *>(png.data()), png.size());
+  return file.good();
+}
+
+// BT.601 studio range 4:2:0, chroma averaged over 2x2 pixels. Frames are
+// converted in parallel and written in sequence.
+bool FrameCapture::writeY4m(const Frame &frame, std::vector<GLubyte> &yuv) {
+  const GLsizei width = frame.width, height = frame.height;
+  const GLsizei chroma_width = (width + 1) / 2;
+  const GLsizei chroma_height = (height + 1) / 2;
+  const size_t luma_size = static_cast<size_t>(width) * height;
+  const size_t chroma_size = static_cast<size_t>(chroma_width) * chroma_height;
+  yuv.resize(luma_size + 2 * chroma_size);
+  GLubyte *y_plane = yuv.data();
+  GLubyte *u_plane = y_plane + luma_size;
+  GLubyte *v_plane = u_plane + chroma_size;
+  auto pixel = [&](GLsizei x, GLsizei y) {
+    return &frame.pixels[(static_cast<size_t>(height - 1 - y) * width + x) * 4];
+  };
+
+  for (GLsizei y = 0; y < height; y++) {
+    for (GLsizei x = 0; x < width; x++) {
+      const GLubyte *p = pixel(x, y);
+      *y_plane++ = static_cast<GLubyte>(
+          ((66 * p[0] + 129 * p[1] + 25 * p[2] + 128) >> 8) + 16);
+    }
+  }
+  for (GLsizei y = 0; y < chroma_height; y++) {
+    for (GLsizei x = 0; x < chroma_width; x++) {
+      const GLsizei x0 = 2 * x, x1 = std::min(x0 + 1, width - 1);
+      const GLsizei y0 = 2 * y, y1 = std::min(y0 + 1, height - 1);
+      int r = 2, g = 2, b = 2; // rounds the average
+      for (const GLubyte *p : {pixel(x0, y0), pixel(x1, y0), pixel(x0, y1),
+                               pixel(x1, y1)}) {
+        r += p[0];
+        g += p[1];
+        b += p[2];
+      }
+      r >>= 2;
+      g >>= 2;
+      b >>= 2;
+      // offset by 128 << 8 so that the sums are never negative
+      *u_plane++ =
+          static_cast<GLubyte>((-38 * r - 74 * g + 112 * b + 32896) >> 8);
+      *v_plane++ =
+          static_cast<GLubyte>((112 * r - 94 * g - 18 * b + 32896) >> 8);
+    }
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(Mutex);
+    Ordered.wait(lock, [&] { return NextWrite == frame.sequence; });
+  }
+  if (frame.sequence == 0) {
+    Stream << "YUV4MPEG2 W" << width << " H" << height << " F" << FrameRate
+           << ":1 Ip A1:1 C420jpeg\n";
+  }
+  Stream << "FRAME\n";
+  Stream.write(reinterpret_cast<const char *>(yuv.data()), yuv.size());
+  const bool written = Stream.good();
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    NextWrite++;
+  }
+  Ordered.notify_all();
+  return written;
+}
+
+void FrameCapture::report(std::ostream &out) const {
+  if (Calls == 0)
+    return;
+  out << "Capture: " << Captured << " frames read back, " << Written
+      << " written, " << Dropped << " dropped, " << Stalls
+      << " readback stalls, " << Waits << " waits for an encoder, "
+      << CpuMsSum / Calls << " ms average (" << CpuMsMax
+      << " ms max) per frame on the render thread" << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
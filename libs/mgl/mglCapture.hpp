@@ -0,0 +1,127 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Frame Capture Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_CAPTURE_HPP
+#define MGL_CAPTURE_HPP
+
+#include <GL/glew.h>
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mgl {
+
+class FrameCapture;
+
+/////////////////////////////////////////////////////////////////// FrameCapture
+//
+// Saves rendered frames without stalling the pipeline. capture() starts an
+// asynchronous glReadPixels into the next pixel buffer object of a small
+// ring and fences it; the pixels are only mapped once the fence has
+// signalled, a couple of frames later, and copied into a frame handed to the
+// encoder threads. Only when the whole ring is still in flight does capture()
+// wait for the oldest readback.
+//
+// PNG writes every frame to <path>NNNNN.png, numbered by capture, so that
+// dropped frames leave gaps; frames are encoded in parallel. Y4M writes a
+// single raw 4:2:0 stream to path, in capture order, at the size of the first
+// frame; frames of any other size are dropped.
+//
+// At most max_queued frames wait for or are being encoded. When all of them
+// are taken, WAIT blocks capture() until an encoder is done, so that no frame
+// is lost, and DROP skips the frame instead, so that frame times are not
+// disturbed. finish() waits for every readback and encoder, and must be
+// called with the GL context current; the destructor calls it if needed.
+
+class FrameCapture final {
+public:
+  enum Format { PNG, Y4M };
+  enum Policy { WAIT, DROP };
+  static const int SLOTS = 3;
+
+  Format Output;
+  Policy Behind;
+  int FrameRate;    // of Y4M streams
+  GLuint Captured;  // readbacks started
+  GLuint Written;   // frames encoded and written
+  GLuint Dropped;   // by DROP, or of the wrong size for the stream
+  GLuint Stalls;    // readbacks waited for because the ring was full
+  GLuint Waits;     // frames that waited for an encoder under WAIT
+  double CpuMsSum;  // time spent in capture(), on the calling thread
+  double CpuMsMax;
+
+  FrameCapture(const std::string &path, const Format format,
+               const unsigned int encoders = 2, const Policy policy = WAIT,
+               const unsigned int max_queued = 8);
+  ~FrameCapture();
+
+  FrameCapture(const FrameCapture &) = delete;
+  FrameCapture &operator=(const FrameCapture &) = delete;
+
+  void capture(const GLuint framebuffer, const GLsizei width,
+               const GLsizei height);
+  void finish();
+  void report(std::ostream &out) const;
+
+private:
+  struct Slot {
+    GLuint buffer;
+    GLsync fence;
+    GLsizeiptr size;
+    GLsizei width, height;
+    GLuint number;
+  };
+  struct Frame {
+    std::vector<GLubyte> pixels; // RGBA, bottom-up rows
+    GLsizei width, height;
+    GLuint number;   // capture number, names PNG files
+    GLuint sequence; // position in the output, orders Y4M frames
+  };
+
+  std::string Path;
+  Slot Slots[SLOTS];
+  int SlotNext; // oldest readback in flight, or the next one to start
+  GLsizei StreamWidth, StreamHeight;
+  GLuint Sequence;
+  GLuint Calls;
+  bool Finished;
+
+  std::vector<std::thread> Encoders;
+  std::mutex Mutex;
+  std::condition_variable Ready;   // a frame was queued, or quitting
+  std::condition_variable Done;    // a frame was freed
+  std::condition_variable Ordered; // a frame was written to the stream
+  std::deque<Frame *> Queue;
+  std::vector<Frame *> Free;
+  std::vector<std::unique_ptr<Frame>> Frames;
+  unsigned int MaxQueued;
+  GLuint NextWrite;
+  bool Quit;
+  std::ofstream Stream;
+
+  bool signalled(const Slot &slot, const bool wait);
+  void collect(const bool wait);
+  void readback(Slot &slot);
+  Frame *acquire();
+  void encode();
+  bool writePng(const Frame &frame, std::vector<GLubyte> &raw,
+                std::vector<GLubyte> &png);
+  bool writeY4m(const Frame &frame, std::vector<GLubyte> &yuv);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_CAPTURE_HPP */
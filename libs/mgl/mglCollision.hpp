@@ -0,0 +1,111 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Collision World Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_COLLISION_HPP
+#define MGL_COLLISION_HPP
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MGL_COLLISION_SSE2 1
+#else
+#define MGL_COLLISION_SSE2 0
+#endif
+
+namespace mgl {
+
+struct Contact;
+class CollisionWorld;
+
+//////////////////////////////////////////////////////////////////////// Contact
+//
+// Normal points from body a to body b; moving b by depth * normal separates
+// them. A depth of zero or less means the bodies only touch.
+
+struct Contact {
+  GLuint a, b;
+  glm::vec2 normal;
+  GLfloat depth;
+  glm::vec2 point; // deepest vertex of b inside a
+};
+
+///////////////////////////////////////////////////////////////// CollisionWorld
+//
+// Overlap and contact detection between 2D convex polygons placed by a matrix.
+// Shapes are given as points in model space (any order, e.g. the vertices of
+// a mesh) and reduced to their convex hull; only x and y of the world space
+// result are used.
+//
+// update() transforms the bodies whose matrix changed, then:
+//
+//   broadphase   sweep and prune along x. The bodies stay sorted by the left
+//                edge of their box between updates, so re-sorting is an
+//                insertion sort over an almost sorted list. Each box is then
+//                checked against the following ones four at a time.
+//   narrowphase  separating axis test of each pair whose boxes overlap. The
+//                edge normals of both polygons are tested four at a time
+//                (with SSE2), and the axis of least overlap gives the contact.
+//
+// Pairs closer than Slop are reported as touching contacts.
+
+class CollisionWorld final {
+public:
+  static const GLuint MAX_VERTICES = 8;
+
+  GLfloat Slop;
+  GLuint BroadphasePairs; // box overlaps found by the last update()
+  GLuint PairsTested;     // separating axis tests run by the last update()
+
+  CollisionWorld();
+
+  GLuint addShape(const glm::vec2 *points, const GLuint count);
+  GLuint addBody(const GLuint shape, const glm::mat4 &matrix);
+  void setMatrix(const GLuint body, const glm::mat4 &matrix);
+  GLuint size() const;
+  void clear();
+
+  void update();
+  const std::vector<Contact> &getContacts() const;
+  bool test(const GLuint a, const GLuint b, Contact &contact) const;
+
+private:
+  struct Polygon {
+    GLfloat x[MAX_VERTICES], y[MAX_VERTICES];   // world space, padded
+    GLfloat nx[MAX_VERTICES], ny[MAX_VERTICES]; // edge normals, padded
+    GLuint count;
+    glm::vec2 min, max;
+  };
+  struct Box {
+    GLfloat minX, maxX, minY, maxY;
+    GLuint body;
+  };
+
+  std::vector<glm::vec2> ShapeVertices; // convex hulls, counterclockwise
+  std::vector<GLuint> ShapeFirst;       // first vertex of each shape + end
+  std::vector<GLuint> Shapes;
+  std::vector<glm::mat4> Matrices;
+  std::vector<Polygon> Polygons;
+  std::vector<GLubyte> Dirty;
+  std::vector<Box> Sorted; // by minX, kept between updates
+  std::vector<GLfloat> SweepMinX, SweepMaxX, SweepMinY, SweepMaxY;
+  std::vector<std::pair<GLuint, GLuint>> Pairs;
+  std::vector<Contact> Contacts;
+
+  void transform(const GLuint body);
+  void sweep();
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_COLLISION_HPP */
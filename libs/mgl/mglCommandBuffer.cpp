@@ -0,0 +1,47 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Render Command Buffer Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglCommandBuffer.hpp"
+
+namespace mgl {
+
+//////////////////////////////////////////////////////////////// CommandRecorder
+
+void CommandRecorder::draw(ShaderProgram *program, const Mesh &mesh,
+                           const glm::mat4 &matrix, const glm::vec4 &color) {
+  Commands.push_back({program, mesh, 0, 0, 0.0f, {matrix, color}});
+}
+
+void CommandRecorder::draw(const DrawItem &item) { Commands.push_back(item); }
+
+void CommandRecorder::reset() { Commands.clear(); }
+
+////////////////////////////////////////////////////////////////// CommandBuffer
+
+CommandBuffer::CommandBuffer(MeshPool *pool, const unsigned int recorders)
+    : DrawCalls(0), CommandCount(0), Recorders(recorders), Queue(pool) {}
+
+CommandRecorder &CommandBuffer::getRecorder(const unsigned int index) {
+  return Recorders[index];
+}
+
+RenderQueue &CommandBuffer::getQueue() { return Queue; }
+
+void CommandBuffer::submit() {
+  for (auto &r : Recorders) {
+    for (auto &c : r.Commands)
+      Queue.push(c);
+    r.reset();
+  }
+  Queue.submit();
+  CommandCount = Queue.ItemCount;
+  DrawCalls = Queue.DrawCalls;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
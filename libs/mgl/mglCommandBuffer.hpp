@@ -0,0 +1,69 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Render Command Buffer Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_COMMAND_BUFFER_HPP
+#define MGL_COMMAND_BUFFER_HPP
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "./mglMesh.hpp"
+#include "./mglRenderQueue.hpp"
+#include "./mglShader.hpp"
+
+namespace mgl {
+
+class CommandRecorder;
+class CommandBuffer;
+
+//////////////////////////////////////////////////////////////// CommandRecorder
+//
+// Linear arena of draw items owned by a single thread. Its storage is kept
+// across frames, so recording does not allocate once capacity is reached.
+
+class alignas(64) CommandRecorder {
+public:
+  std::vector<DrawItem> Commands;
+
+  void draw(ShaderProgram *program, const Mesh &mesh, const glm::mat4 &matrix,
+            const glm::vec4 &color);
+  void draw(const DrawItem &item);
+  void reset();
+};
+
+////////////////////////////////////////////////////////////////// CommandBuffer
+//
+// Each recording thread uses its own recorder, so recording needs no locking.
+// submit() runs on the GL thread and hands all recorded items, in recorder
+// order, to a RenderQueue that sorts and batches them.
+
+class CommandBuffer final {
+public:
+  GLuint DrawCalls;
+  GLuint CommandCount;
+
+  CommandBuffer(MeshPool *pool, const unsigned int recorders);
+
+  CommandBuffer(const CommandBuffer &) = delete;
+  CommandBuffer &operator=(const CommandBuffer &) = delete;
+
+  CommandRecorder &getRecorder(const unsigned int index);
+  RenderQueue &getQueue();
+  void submit();
+
+private:
+  std::vector<CommandRecorder> Recorders;
+  RenderQueue Queue;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_COMMAND_BUFFER_HPP */
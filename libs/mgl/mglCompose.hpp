@@ -0,0 +1,173 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Batch Transform Composition
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_COMPOSE_HPP
+#define MGL_COMPOSE_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MGL_COMPOSE_SSE2 1
+#include <emmintrin.h>
+#else
+#define MGL_COMPOSE_SSE2 0
+#endif
+
+namespace mgl {
+
+//////////////////////////////////////////////////////////////////// composeTRS
+//
+// Writes matrices[i] = translate(T) * mat4_cast(R) * scale(S) for each of the
+// count transforms, directly from the components: no identity matrices and no
+// 4x4 products. With SSE2, four transforms are composed at once, with either
+// quaternions or angles, their components transposed into one register per
+// field.
+//
+// Only depends on glm, so it can be used outside of an OpenGL context (the glm
+// perf tests include it).
+
+inline void composeTRS(const glm::vec3 &t, const glm::quat &r,
+                       const glm::vec3 &s, glm::mat4 &m) {
+  const float xx = r.x * r.x, yy = r.y * r.y, zz = r.z * r.z;
+  const float xy = r.x * r.y, xz = r.x * r.z, yz = r.y * r.z;
+  const float wx = r.w * r.x, wy = r.w * r.y, wz = r.w * r.z;
+  m[0] = glm::vec4((1.0f - 2.0f * (yy + zz)) * s.x, 2.0f * (xy + wz) * s.x,
+                   2.0f * (xz - wy) * s.x, 0.0f);
+  m[1] = glm::vec4(2.0f * (xy - wz) * s.y, (1.0f - 2.0f * (xx + zz)) * s.y,
+                   2.0f * (yz + wx) * s.y, 0.0f);
+  m[2] = glm::vec4(2.0f * (xz + wy) * s.z, 2.0f * (yz - wx) * s.z,
+                   (1.0f - 2.0f * (xx + yy)) * s.z, 0.0f);
+  m[3] = glm::vec4(t, 1.0f);
+}
+
+#if MGL_COMPOSE_SSE2
+namespace detail {
+
+// Column col of four consecutive matrices, from one register per row
+inline void storeColumns(glm::mat4 *m, const int col, __m128 r0, __m128 r1,
+                         __m128 r2, __m128 r3) {
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+  _mm_storeu_ps(&m[0][col][0], r0);
+  _mm_storeu_ps(&m[1][col][0], r1);
+  _mm_storeu_ps(&m[2][col][0], r2);
+  _mm_storeu_ps(&m[3][col][0], r3);
+}
+
+} // namespace detail
+#endif
+
+inline void composeTRS(const glm::vec3 *translations,
+                       const glm::quat *rotations, const glm::vec3 *scales,
+                       glm::mat4 *matrices, const std::size_t count) {
+  std::size_t i = 0;
+#if MGL_COMPOSE_SSE2
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 two = _mm_set1_ps(2.0f);
+  const __m128 zero = _mm_setzero_ps();
+  for (; i + 4 <= count; i += 4) {
+    const float *q = reinterpret_cast<const float *>(rotations + i);
+    __m128 qx = _mm_loadu_ps(q);
+    __m128 qy = _mm_loadu_ps(q + 4);
+    __m128 qz = _mm_loadu_ps(q + 8);
+    __m128 qw = _mm_loadu_ps(q + 12);
+    _MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+#ifdef GLM_FORCE_QUAT_DATA_WXYZ
+    const __m128 w = qx;
+    qx = qy;
+    qy = qz;
+    qz = qw;
+    qw = w;
+#endif
+    const glm::vec3 *s = scales + i;
+    const glm::vec3 *t = translations + i;
+    const __m128 sx = _mm_setr_ps(s[0].x, s[1].x, s[2].x, s[3].x);
+    const __m128 sy = _mm_setr_ps(s[0].y, s[1].y, s[2].y, s[3].y);
+    const __m128 sz = _mm_setr_ps(s[0].z, s[1].z, s[2].z, s[3].z);
+
+    const __m128 xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy);
+    const __m128 zz = _mm_mul_ps(qz, qz), xy = _mm_mul_ps(qx, qy);
+    const __m128 xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+    const __m128 wx = _mm_mul_ps(qw, qx), wy = _mm_mul_ps(qw, qy);
+    const __m128 wz = _mm_mul_ps(qw, qz);
+
+    detail::storeColumns(
+        matrices + i, 0,
+        _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx),
+        _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx),
+        _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx), zero);
+    detail::storeColumns(
+        matrices + i, 1, _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy),
+        _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy),
+        _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy), zero);
+    detail::storeColumns(
+        matrices + i, 2, _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz),
+        _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz),
+        _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz),
+        zero);
+    detail::storeColumns(matrices + i, 3,
+                         _mm_setr_ps(t[0].x, t[1].x, t[2].x, t[3].x),
+                         _mm_setr_ps(t[0].y, t[1].y, t[2].y, t[3].y),
+                         _mm_setr_ps(t[0].z, t[1].z, t[2].z, t[3].z), one);
+  }
+#endif
+  for (; i < count; i++)
+    composeTRS(translations[i], rotations[i], scales[i], matrices[i]);
+}
+
+// 2D transforms: rotation by an angle in radians around the Z axis. With
+// SSE2, sines and cosines are still taken one lane at a time with std::sin and
+// std::cos, so results match the scalar path; the products and the stores are
+// done four transforms at a time.
+inline void composeTRS(const glm::vec2 *translations, const float *angles,
+                       const glm::vec2 *scales, glm::mat4 *matrices,
+                       const std::size_t count) {
+  std::size_t i = 0;
+#if MGL_COMPOSE_SSE2
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 zero = _mm_setzero_ps();
+  for (; i + 4 <= count; i += 4) {
+    const float *a = angles + i;
+    const __m128 c = _mm_setr_ps(std::cos(a[0]), std::cos(a[1]),
+                                 std::cos(a[2]), std::cos(a[3]));
+    const __m128 s = _mm_setr_ps(std::sin(a[0]), std::sin(a[1]),
+                                 std::sin(a[2]), std::sin(a[3]));
+    const glm::vec2 *sc = scales + i;
+    const glm::vec2 *t = translations + i;
+    const __m128 sx = _mm_setr_ps(sc[0].x, sc[1].x, sc[2].x, sc[3].x);
+    const __m128 sy = _mm_setr_ps(sc[0].y, sc[1].y, sc[2].y, sc[3].y);
+
+    detail::storeColumns(matrices + i, 0, _mm_mul_ps(c, sx),
+                         _mm_mul_ps(s, sx), zero, zero);
+    detail::storeColumns(matrices + i, 1,
+                         _mm_mul_ps(_mm_sub_ps(zero, s), sy),
+                         _mm_mul_ps(c, sy), zero, zero);
+    detail::storeColumns(matrices + i, 2, zero, zero, one, zero);
+    detail::storeColumns(matrices + i, 3,
+                         _mm_setr_ps(t[0].x, t[1].x, t[2].x, t[3].x),
+                         _mm_setr_ps(t[0].y, t[1].y, t[2].y, t[3].y), zero,
+                         one);
+  }
+#endif
+  for (; i < count; i++) {
+    const float c = std::cos(angles[i]), s = std::sin(angles[i]);
+    glm::mat4 &m = matrices[i];
+    m[0] = glm::vec4(c * scales[i].x, s * scales[i].x, 0.0f, 0.0f);
+    m[1] = glm::vec4(-s * scales[i].y, c * scales[i].y, 0.0f, 0.0f);
+    m[2] = glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
+    m[3] = glm::vec4(translations[i], 0.0f, 1.0f);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_COMPOSE_HPP */
@@ -10,11 +10,23 @@
 
 #include <GL/glew.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
 
 ////////////////////////////////////////////////////// DEBUG OUTPUT (OPENGL 4.3)
 
-const std::string errorSource(GLenum source) {
+const char *errorSource(GLenum source) {
   switch (source) {
   case GL_DEBUG_SOURCE_API:
     return "API";
@@ -29,11 +41,11 @@ const std::string errorSource(GLenum source) {
   case GL_DEBUG_SOURCE_OTHER:
     return "other";
   default:
-    exit(EXIT_FAILURE);
+    return "unknown";
   }
 }
 
-const std::string errorType(GLenum type) {
+const char *errorType(GLenum type) {
   switch (type) {
   case GL_DEBUG_TYPE_ERROR:
     return "error";
@@ -54,11 +66,11 @@ const std::string errorType(GLenum type) {
   case GL_DEBUG_TYPE_OTHER_ARB:
     return "other";
   default:
-    exit(EXIT_FAILURE);
+    return "unknown";
   }
 }
 
-const std::string errorSeverity(GLenum severity) {
+const char *errorSeverity(GLenum severity) {
   switch (severity) {
   case GL_DEBUG_SEVERITY_HIGH:
     return "high";
@@ -69,13 +81,12 @@ const std::string errorSeverity(GLenum severity) {
   case GL_DEBUG_SEVERITY_NOTIFICATION:
     return "notification";
   default:
-    exit(EXIT_FAILURE);
+    return "unknown";
   }
 }
 
-void error(GLenum source, GLenum type, GLuint id, GLenum severity,
-           GLsizei length, const GLchar *message, const void *userParam) {
-
+static void printDebugMessage(GLenum source, GLenum type, GLuint id,
+                              GLenum severity, const GLchar *message) {
   if (severity == GL_DEBUG_SEVERITY_LOW ||
       severity == GL_DEBUG_SEVERITY_MEDIUM) {
     std::cerr << "GL WARNING:" << std::endl;
@@ -85,29 +96,375 @@ void error(GLenum source, GLenum type, GLuint id, GLenum severity,
   std::cerr << "  source:     " << errorSource(source) << std::endl;
   std::cerr << "  type:       " << errorType(type) << std::endl;
   std::cerr << "  severity:   " << errorSeverity(severity) << std::endl;
+  std::cerr << "  id:         " << id << std::endl;
   std::cerr << "  debug call: " << std::endl
             << message << std::endl
             << std::endl;
+}
+
+void GLAPIENTRY error(GLenum source, GLenum type, GLuint id, GLenum severity,
+                     GLsizei length, const GLchar *message,
+                     const void *userParam) {
+  printDebugMessage(source, type, id, severity, message);
   if (severity == GL_DEBUG_SEVERITY_HIGH) {
     exit(EXIT_FAILURE);
   }
 }
 
-void setupDebugOutput() {
+static std::vector<GLuint> IgnoredIds;
+static bool DebugOutputActive = false;
+
+// Ids can only be filtered for a given source and type, so every pair is set
+static void applyIgnoredIds() {
+  static const GLenum sources[] = {
+      GL_DEBUG_SOURCE_API,          GL_DEBUG_SOURCE_WINDOW_SYSTEM,
+      GL_DEBUG_SOURCE_SHADER_COMPILER, GL_DEBUG_SOURCE_THIRD_PARTY,
+      GL_DEBUG_SOURCE_APPLICATION,  GL_DEBUG_SOURCE_OTHER};
+  static const GLenum types[] = {
+      GL_DEBUG_TYPE_ERROR,          GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR,
+      GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR, GL_DEBUG_TYPE_PORTABILITY,
+      GL_DEBUG_TYPE_PERFORMANCE,    GL_DEBUG_TYPE_MARKER,
+      GL_DEBUG_TYPE_PUSH_GROUP,     GL_DEBUG_TYPE_POP_GROUP,
+      GL_DEBUG_TYPE_OTHER};
+  if (IgnoredIds.empty())
+    return;
+  for (GLenum source : sources) {
+    for (GLenum type : types) {
+      glDebugMessageControl(source, type, GL_DONT_CARE,
+                            static_cast<GLsizei>(IgnoredIds.size()),
+                            IgnoredIds.data(), GL_FALSE);
+    }
+  }
+}
+
+static void enableDebugOutput(GLDEBUGPROC callback, const void *user,
+                              bool synchronous) {
   int context_flags = 0;
   glGetIntegerv(GL_CONTEXT_FLAGS, &context_flags);
   if (context_flags & GL_CONTEXT_FLAG_DEBUG_BIT) {
     std::cout << "Debug context created." << std::endl;
   }
   glEnable(GL_DEBUG_OUTPUT);
-  glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-  glDebugMessageCallback(error, nullptr);
+  if (synchronous)
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+  else
+    glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+  glDebugMessageCallback(callback, user);
   glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr,
                         GL_TRUE);
   // glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE,
   //                       GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr,
   //                       GL_FALSE);
   // params: source, type, severity, count, ids, enabled
+  applyIgnoredIds();
+  DebugOutputActive = true;
+}
+
+void setupDebugOutput() {
+  enableDebugOutput(error, nullptr, true);
+}
+
+void ignoreDebugMessages(const GLuint *ids, const GLsizei count) {
+  IgnoredIds.insert(IgnoredIds.end(), ids, ids + count);
+  if (DebugOutputActive)
+    applyIgnoredIds();
+}
+
+///////////////////////////////////////////////// ASYNCHRONOUS DEBUG OUTPUT
+
+// Longer messages are truncated
+static const GLsizei DEBUG_MESSAGE_SIZE = 256;
+static const size_t DEBUG_QUEUE_SIZE = 1024; // a power of two
+
+struct DebugRecord {
+  GLenum source, type, severity;
+  GLuint id;
+  GLchar message[DEBUG_MESSAGE_SIZE];
+};
+
+// Bounded queue without locks for many producers, as the driver may call
+// back from any of its threads, and one consumer. The sequence number of a
+// slot tells whether it is free for the producer that claimed its position
+// or holds a record for the consumer.
+class DebugQueue final {
+public:
+  DebugQueue() : Slots(new Slot[DEBUG_QUEUE_SIZE]), Head(0), Tail(0) {
+    for (size_t i = 0; i < DEBUG_QUEUE_SIZE; i++)
+      Slots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  bool push(GLenum source, GLenum type, GLuint id, GLenum severity,
+            GLsizei length, const GLchar *message) {
+    size_t position = Head.load(std::memory_order_relaxed);
+    Slot *slot;
+    for (;;) {
+      slot = &Slots[position & (DEBUG_QUEUE_SIZE - 1)];
+      const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+      if (sequence == position) {
+        if (Head.compare_exchange_weak(position, position + 1,
+                                       std::memory_order_relaxed))
+          break;
+      } else if (sequence < position) {
+        return false; // full
+      } else {
+        position = Head.load(std::memory_order_relaxed);
+      }
+    }
+    DebugRecord &r = slot->record;
+    r.source = source;
+    r.type = type;
+    r.id = id;
+    r.severity = severity;
+    if (length < 0)
+      length = static_cast<GLsizei>(std::strlen(message));
+    length = std::min(length, DEBUG_MESSAGE_SIZE - 1);
+    std::memcpy(r.message, message, length);
+    r.message[length] = 0;
+    slot->sequence.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(DebugRecord &record) {
+    Slot &slot = Slots[Tail & (DEBUG_QUEUE_SIZE - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != Tail + 1)
+      return false;
+    record = slot.record;
+    slot.sequence.store(Tail + DEBUG_QUEUE_SIZE, std::memory_order_release);
+    Tail++;
+    return true;
+  }
+
+private:
+  struct Slot {
+    std::atomic<size_t> sequence;
+    DebugRecord record;
+  };
+  std::unique_ptr<Slot[]> Slots;
+  alignas(64) std::atomic<size_t> Head;
+  alignas(64) size_t Tail; // consumer only
+};
+
+// Counts per id, kept by the callers of the callback so that repeats are
+// counted and rate limited before anything is copied. Open addressing over a
+// fixed number of ids; ids that do not fit are neither counted nor limited.
+class DebugIdTable final {
+public:
+  static const size_t SIZE = 256; // a power of two
+  static const GLuint EMPTY = 0xFFFFFFFF;
+
+  struct Entry {
+    std::atomic<GLuint> id;
+    std::atomic<unsigned long> total;
+    std::atomic<unsigned long long> window; // second << 32 | admitted
+  };
+
+  DebugIdTable() : Entries(new Entry[SIZE]) {
+    for (size_t i = 0; i < SIZE; i++) {
+      Entries[i].id.store(EMPTY, std::memory_order_relaxed);
+      Entries[i].total.store(0, std::memory_order_relaxed);
+      Entries[i].window.store(0xFFFFFFFFull << 32, std::memory_order_relaxed);
+    }
+  }
+
+  // Finds or claims the entry of an id, nullptr when the table is full
+  Entry *find(const GLuint id, const bool insert) const {
+    const size_t hash = (id * 2654435761u) & (SIZE - 1);
+    for (size_t i = 0; i < SIZE; i++) {
+      Entry &e = Entries[(hash + i) & (SIZE - 1)];
+      GLuint current = e.id.load(std::memory_order_acquire);
+      if (current == EMPTY && insert &&
+          e.id.compare_exchange_strong(current, id))
+        return &e;
+      if (current == id)
+        return &e;
+      if (current == EMPTY)
+        return nullptr;
+    }
+    return nullptr;
+  }
+
+  // Whether another message of this id may be queued in the given second
+  static bool admit(Entry &e, const GLuint second, const GLuint limit) {
+    unsigned long long window = e.window.load(std::memory_order_relaxed);
+    for (;;) {
+      unsigned long long next;
+      if (static_cast<GLuint>(window >> 32) != second)
+        next = (static_cast<unsigned long long>(second) << 32) | 1;
+      else if ((window & 0xFFFFFFFF) < limit)
+        next = window + 1;
+      else
+        return false;
+      if (e.window.compare_exchange_weak(window, next,
+                                         std::memory_order_relaxed))
+        return true;
+    }
+  }
+
+private:
+  std::unique_ptr<Entry[]> Entries;
+};
+
+// The background thread drains the queue a few times per second. Messages
+// rate limited or dropped by the callback are reported as not shown, once
+// per second and per id.
+class DebugLogger final {
+public:
+  DebugQueue Queue;
+  DebugIdTable Ids;
+  std::atomic<unsigned long> Dropped;
+  const GLuint RateLimit;
+
+  explicit DebugLogger(const unsigned int rate_limit)
+      : Dropped(0), RateLimit(std::max(rate_limit, 1u)), Start(Clock::now()),
+        LastReport(0.0), Quit(false) {
+    Thread = std::thread(&DebugLogger::loop, this);
+  }
+
+  ~DebugLogger() {
+    {
+      std::lock_guard<std::mutex> lock(Mutex);
+      Quit = true;
+    }
+    Wake.notify_one();
+    Thread.join();
+    report();
+  }
+
+  double seconds() const {
+    return std::chrono::duration<double>(Clock::now() - Start).count();
+  }
+
+private:
+  typedef std::chrono::steady_clock Clock;
+  struct Counter {
+    unsigned long shown;
+    unsigned long hidden; // already reported as not shown
+    GLenum source, type, severity;
+  };
+  const Clock::time_point Start;
+  std::map<GLuint, Counter> Counters;
+  double LastReport;
+  std::thread Thread;
+  std::mutex Mutex;
+  std::condition_variable Wake;
+  bool Quit;
+
+  void loop() {
+    std::unique_lock<std::mutex> lock(Mutex);
+    while (!Quit) {
+      lock.unlock();
+      drain();
+      lock.lock();
+      Wake.wait_for(lock, std::chrono::milliseconds(50), [this] {
+        return Quit;
+      });
+    }
+    lock.unlock();
+    drain();
+  }
+
+  void drain() {
+    DebugRecord r;
+    while (Queue.pop(r))
+      show(r);
+    const double now = seconds();
+    if (now - LastReport >= 1.0) {
+      reportHidden();
+      LastReport = now;
+    }
+  }
+
+  void show(const DebugRecord &r) {
+    auto inserted = Counters.insert({r.id, {0, 0, 0, 0, 0}});
+    Counter &c = inserted.first->second;
+    c.shown++;
+    c.source = r.source;
+    c.type = r.type;
+    c.severity = r.severity;
+    if (inserted.second) {
+      printDebugMessage(r.source, r.type, r.id, r.severity, r.message);
+    } else {
+      std::cerr << "GL debug #" << r.id << " (" << errorSeverity(r.severity)
+                << "): " << r.message << std::endl;
+    }
+  }
+
+  unsigned long total(const GLuint id, const Counter &c) const {
+    const DebugIdTable::Entry *e = Ids.find(id, false);
+    const unsigned long counted =
+        e ? e->total.load(std::memory_order_relaxed) : 0;
+    return std::max(counted, c.shown + c.hidden);
+  }
+
+  void reportHidden() {
+    for (auto &entry : Counters) {
+      Counter &c = entry.second;
+      const unsigned long hidden = total(entry.first, c) - c.shown - c.hidden;
+      if (hidden > 0) {
+        std::cerr << "GL debug #" << entry.first << ": " << hidden
+                  << " more messages not shown" << std::endl;
+        c.hidden += hidden;
+      }
+    }
+  }
+
+  // Most frequent ids first
+  void report() {
+    reportHidden();
+    std::vector<std::pair<unsigned long, GLuint>> ids;
+    unsigned long messages = 0, hidden = 0;
+    for (auto &entry : Counters) {
+      ids.push_back({entry.second.shown + entry.second.hidden, entry.first});
+      messages += ids.back().first;
+      hidden += entry.second.hidden;
+    }
+    std::sort(ids.rbegin(), ids.rend());
+    std::cerr << "GL debug output: " << messages << " messages from "
+              << ids.size() << " ids, " << hidden << " not shown ("
+              << Dropped.load() << " dropped from a full queue)" << std::endl;
+    for (size_t i = 0; i < ids.size() && i < 10; i++) {
+      const Counter &c = Counters[ids[i].second];
+      std::cerr << "  #" << ids[i].second << ": " << ids[i].first << " ("
+                << errorSource(c.source) << ", " << errorType(c.type) << ", "
+                << errorSeverity(c.severity) << ")" << std::endl;
+    }
+  }
+};
+
+static std::unique_ptr<DebugLogger> Logger;
+
+static void GLAPIENTRY queueDebugMessage(GLenum source, GLenum type, GLuint id,
+                                         GLenum severity, GLsizei length,
+                                         const GLchar *message,
+                                         const void *userParam) {
+  DebugLogger *logger =
+      const_cast<DebugLogger *>(static_cast<const DebugLogger *>(userParam));
+  DebugIdTable::Entry *e = logger->Ids.find(id, true);
+  if (e) {
+    e->total.fetch_add(1, std::memory_order_relaxed);
+    const GLuint second = static_cast<GLuint>(logger->seconds());
+    if (!DebugIdTable::admit(*e, second, logger->RateLimit))
+      return;
+  }
+  if (!logger->Queue.push(source, type, id, severity, length, message))
+    logger->Dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void setupAsyncDebugOutput(const unsigned int rate_limit) {
+  Logger.reset(new DebugLogger(rate_limit));
+  enableDebugOutput(queueDebugMessage, Logger.get(), false);
+}
+
+// The driver may still be calling back from its own threads until all work
+// that could report anything is done
+void stopDebugOutput() {
+  if (!Logger)
+    return;
+  glFinish();
+  glDisable(GL_DEBUG_OUTPUT);
+  glDebugMessageCallback(nullptr, nullptr);
+  DebugOutputActive = false;
+  Logger.reset();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -9,9 +9,30 @@
 #ifndef MGL_ERROR_HPP
 #define MGL_ERROR_HPP
 
+#include <GL/glew.h>
+
 ////////////////////////////////////////////////////// Debug Output (OpenGL 4.3)
+//
+// setupDebugOutput() prints every message from within the GL call that
+// caused it and exits on high severity messages, which is what is wanted to
+// find the call at fault, but costs a string formatting and a console write
+// per message on the rendering thread.
+//
+// setupAsyncDebugOutput() only copies the raw message into a lock-free queue
+// and lets the driver report it whenever it likes. A background thread drains
+// the queue, prints the first message of each id in full and at most
+// rate_limit of them per id and per second afterwards, and counts the rest.
+// Nothing exits: by the time a message is printed, the call that caused it is
+// long gone. stopDebugOutput() prints the remaining messages and the count of
+// each id seen.
+//
+// ignoreDebugMessages() silences ids in the driver, for both modes; it can be
+// called before the context exists, the ids are applied when output starts.
 
 void setupDebugOutput();
+void setupAsyncDebugOutput(const unsigned int rate_limit = 10);
+void ignoreDebugMessages(const GLuint *ids, const GLsizei count);
+void stopDebugOutput();
 
 ////////////////////////////////////////////////////////////////////////////////
 #endif /* MGL_ERROR_HPP */
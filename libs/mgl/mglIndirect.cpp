@@ -0,0 +1,157 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Indirect Renderer Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglIndirect.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+#include "./mglState.hpp"
+
+namespace mgl {
+
+/////////////////////////////////////////////////////////////// IndirectRenderer
+
+const GLuint IndirectRenderer::INSTANCE_BINDING;
+const GLuint IndirectRenderer::VISIBLE_BINDING;
+const GLuint IndirectRenderer::COMMAND_BINDING;
+const GLuint IndirectRenderer::GROUP_SIZE;
+
+IndirectRenderer::IndirectRenderer(MeshPool *pool)
+    : BufferIds{0, 0, 0}, InstanceCount(0), Pool(pool) {
+  glGenBuffers(3, BufferIds);
+}
+
+IndirectRenderer::~IndirectRenderer() {
+  StateCache &state = StateCache::getInstance();
+  for (GLuint id : BufferIds)
+    state.forgetBuffer(id);
+  glDeleteBuffers(3, BufferIds);
+}
+
+bool IndirectRenderer::isSupported() {
+  return GLEW_VERSION_4_3 && GLEW_ARB_shader_draw_parameters;
+}
+
+GLuint IndirectRenderer::addMesh(const Mesh &mesh) {
+  Commands.push_back({static_cast<GLuint>(mesh.count), 0, mesh.firstIndex,
+                      mesh.baseVertex, 0});
+  return static_cast<GLuint>(Commands.size() - 1);
+}
+
+// Each mesh gets a range of the visible buffer as large as its number of
+// instances, starting at the base instance of its command.
+void IndirectRenderer::setInstances(const GpuInstance *instances,
+                                    const GLuint count) {
+  std::vector<GLuint> counts(Commands.size(), 0);
+  for (GLuint i = 0; i < count; i++) {
+    if (instances[i].mesh >= Commands.size()) {
+      std::cerr << "[ERROR] Instance " << i << " has unknown mesh "
+                << instances[i].mesh << std::endl;
+      throw std::runtime_error("Unknown instance mesh.");
+    }
+    counts[instances[i].mesh]++;
+  }
+  GLuint base = 0;
+  for (size_t m = 0; m < Commands.size(); m++) {
+    Commands[m].baseInstance = base;
+    base += counts[m];
+  }
+  InstanceCount = count;
+
+  StateCache &state = StateCache::getInstance();
+  state.bindBuffer(GL_SHADER_STORAGE_BUFFER, BufferIds[0]);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GpuInstance) * count,
+               instances, GL_DYNAMIC_DRAW);
+  state.bindBuffer(GL_SHADER_STORAGE_BUFFER, BufferIds[1]);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * count, nullptr,
+               GL_DYNAMIC_COPY);
+  state.bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, BufferIds[2]);
+  glBufferData(GL_DRAW_INDIRECT_BUFFER,
+               sizeof(DrawElementsCommand) * Commands.size(), Commands.data(),
+               GL_DYNAMIC_COPY);
+  state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void IndirectRenderer::updateInstances(const GpuInstance *instances,
+                                       const GLuint first,
+                                       const GLuint count) {
+  StateCache &state = StateCache::getInstance();
+  state.bindBuffer(GL_SHADER_STORAGE_BUFFER, BufferIds[0]);
+  glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(GpuInstance) * first,
+                  sizeof(GpuInstance) * count, instances);
+  state.bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void IndirectRenderer::bindBuffers(const bool commands) {
+  StateCache &state = StateCache::getInstance();
+  state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_BINDING,
+                       BufferIds[0]);
+  state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, VISIBLE_BINDING,
+                       BufferIds[1]);
+  if (commands)
+    state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMAND_BINDING,
+                         BufferIds[2]);
+}
+
+// The instance counts are reset from the CPU copy of the commands, which
+// always holds zero; this is the only per-frame upload, one command per mesh.
+void IndirectRenderer::cull(ShaderProgram &program) {
+  if (InstanceCount == 0)
+    return;
+  StateCache &state = StateCache::getInstance();
+  state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, BufferIds[2]);
+  glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0,
+                  sizeof(DrawElementsCommand) * Commands.size(),
+                  Commands.data());
+  state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+  bindBuffers(true);
+  program.bind();
+  glDispatchCompute((InstanceCount + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+  program.unbind();
+  glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+// The pool's instance attributes are not read by the program, but they are
+// enabled in its VAO and must be backed by a buffer large enough for every
+// instance index.
+void IndirectRenderer::draw(ShaderProgram &program) {
+  if (InstanceCount == 0)
+    return;
+  StateCache &state = StateCache::getInstance();
+  Pool->bindInstanceBuffer(BufferIds[0], sizeof(GpuInstance));
+  bindBuffers(false);
+  state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, BufferIds[2]);
+  program.bind();
+  Pool->bind();
+  Pool->drawIndirect(0, static_cast<GLsizei>(Commands.size()));
+  Pool->unbind();
+  program.unbind();
+  state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+// Reads back the commands written by the last cull(), which waits for the GPU
+// to finish it. Meant for statistics, not for every frame.
+GLuint IndirectRenderer::readVisibleCount() {
+  std::vector<DrawElementsCommand> commands(Commands.size());
+  StateCache &state = StateCache::getInstance();
+  state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, BufferIds[2]);
+  glGetBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0,
+                     sizeof(DrawElementsCommand) * commands.size(),
+                     commands.data());
+  state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  GLuint visible = 0;
+  for (const DrawElementsCommand &c : commands)
+    visible += c.instanceCount;
+  return visible;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
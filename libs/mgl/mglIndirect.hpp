@@ -0,0 +1,98 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Indirect Renderer Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_INDIRECT_HPP
+#define MGL_INDIRECT_HPP
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "./mglMesh.hpp"
+#include "./mglShader.hpp"
+
+namespace mgl {
+
+struct GpuInstance;
+class IndirectRenderer;
+
+//////////////////////////////////////////////////////////////////// GpuInstance
+//
+// Per-instance record of the instance storage buffer, in std430 layout.
+
+struct GpuInstance {
+  glm::mat4 matrix;
+  glm::vec4 color;
+  glm::vec4 bounds; // bounding sphere in model space: center xyz, radius w
+  GLuint mesh;      // as returned by IndirectRenderer::addMesh()
+  GLuint reserved[3];
+};
+
+/////////////////////////////////////////////////////////////// IndirectRenderer
+//
+// GPU-driven drawing of every instance of a scene with a single
+// glMultiDrawElementsIndirect, so the CPU cost of a frame does not depend on
+// the number of instances.
+//
+// Instances live in a shader storage buffer. cull() runs a compute program
+// that tests each instance's bounding sphere against the view frustum and,
+// for the visible ones, appends its index to the range of its mesh in the
+// visible buffer and bumps the instance count of the mesh's draw command.
+// draw() then issues one command per mesh, and the vertex program fetches
+// its instance with visible[gl_BaseInstance + gl_InstanceID].
+//
+// The programs must declare the buffers at these shader storage bindings:
+//
+//   INSTANCE_BINDING  GpuInstance instances[]
+//   VISIBLE_BINDING   uint visible[]
+//   COMMAND_BINDING   DrawElementsCommand commands[] (cull program only)
+//
+// and the cull program must have a local size of GROUP_SIZE. Requires
+// OpenGL 4.3 and ARB_shader_draw_parameters (core in 4.6) for gl_BaseInstance
+// in the vertex program.
+//
+// updateInstances() may change anything but the mesh of an instance, which
+// would move it to another range of the visible buffer; use setInstances().
+
+class IndirectRenderer final {
+public:
+  static const GLuint INSTANCE_BINDING = 0;
+  static const GLuint VISIBLE_BINDING = 1;
+  static const GLuint COMMAND_BINDING = 2;
+  static const GLuint GROUP_SIZE = 64;
+
+  GLuint BufferIds[3]; // instances, visible indices, indirect commands
+  GLuint InstanceCount;
+
+  explicit IndirectRenderer(MeshPool *pool);
+  ~IndirectRenderer();
+
+  IndirectRenderer(const IndirectRenderer &) = delete;
+  IndirectRenderer &operator=(const IndirectRenderer &) = delete;
+
+  static bool isSupported();
+  GLuint addMesh(const Mesh &mesh);
+  void setInstances(const GpuInstance *instances, const GLuint count);
+  void updateInstances(const GpuInstance *instances, const GLuint first,
+                       const GLuint count);
+  void cull(ShaderProgram &program);
+  void draw(ShaderProgram &program);
+  GLuint readVisibleCount();
+
+private:
+  MeshPool *Pool;
+  std::vector<DrawElementsCommand> Commands;
+
+  void bindBuffers(const bool commands);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_INDIRECT_HPP */
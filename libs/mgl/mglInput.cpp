@@ -0,0 +1,82 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Input Event Queue
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglInput.hpp"
+
+namespace mgl {
+
+///////////////////////////////////////////////////////////////////// InputQueue
+
+InputQueue::InputQueue(const size_t capacity)
+    : Dropped(0), Coalesced(0), Mask(0), Reserved(0), Head(0), Tail(0) {
+  size_t size = 2;
+  while (size < capacity)
+    size *= 2;
+  Events.reset(new InputEvent[size]);
+  Mask = size - 1;
+  Reserved = size / 4;
+}
+
+size_t InputQueue::capacity() const { return Mask + 1; }
+
+bool InputQueue::empty() const {
+  return Tail.load(std::memory_order_acquire) ==
+         Head.load(std::memory_order_acquire);
+}
+
+// Producer only. The event is written before Head is published, so the
+// consumer never sees a half written event.
+bool InputQueue::push(const InputEvent &event) {
+  const size_t head = Head.load(std::memory_order_relaxed);
+  const size_t used = head - Tail.load(std::memory_order_acquire);
+  const bool coalescable = event.type == InputEventType::CURSOR ||
+                           event.type == InputEventType::SCROLL;
+  if (used > Mask || (coalescable && used + Reserved > Mask)) {
+    Dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  Events[head & Mask] = event;
+  Head.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+// Consumer only
+bool InputQueue::pop(InputEvent &event) {
+  const size_t tail = Tail.load(std::memory_order_relaxed);
+  if (tail == Head.load(std::memory_order_acquire))
+    return false;
+  event = Events[tail & Mask];
+  Tail.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+void InputQueue::drain(std::vector<InputEvent> &batch) {
+  batch.clear();
+  InputEvent event;
+  while (pop(event)) {
+    if (!batch.empty() && batch.back().type == event.type) {
+      InputEvent &last = batch.back();
+      if (event.type == InputEventType::CURSOR) {
+        last.x = event.x;
+        last.y = event.y;
+        Coalesced++;
+        continue;
+      }
+      if (event.type == InputEventType::SCROLL) {
+        last.x += event.x;
+        last.y += event.y;
+        Coalesced++;
+        continue;
+      }
+    }
+    batch.push_back(event);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
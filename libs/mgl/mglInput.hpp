@@ -0,0 +1,91 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Input Event Queue
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_INPUT_HPP
+#define MGL_INPUT_HPP
+
+#include <GL/glew.h>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace mgl {
+
+enum class InputEventType;
+struct InputEvent;
+class InputQueue;
+
+///////////////////////////////////////////////////////////////////// InputEvent
+
+enum class InputEventType {
+  CURSOR,
+  KEY,
+  MOUSE_BUTTON,
+  SCROLL,
+  JOYSTICK,
+  WINDOW_SIZE,
+  FRAMEBUFFER_SIZE,
+  WINDOW_CLOSE
+};
+
+struct InputEvent {
+  InputEventType type;
+  int code;     // key, mouse button or joystick id
+  int scancode;
+  int action;   // key or button action, or joystick event
+  int mods;
+  double x, y;  // cursor position, scroll offset or size
+  double time;  // seconds, as glfwGetTime(), when the event was received
+};
+
+///////////////////////////////////////////////////////////////////// InputQueue
+//
+// Fixed size ring of events between one producer thread (the one receiving
+// GLFW callbacks) and one consumer thread (the one running the App), with no
+// locks. When the ring is full, new events are dropped and counted. Cursor
+// moves and scrolls are dropped once it is three quarters full, keeping the
+// last quarter for keys, buttons, resizes and closing, so that a flood of
+// movement never costs a key release.
+//
+// drain() empties the ring into a batch and coalesces runs of events that
+// only matter in total: consecutive cursor moves become the last one, and
+// consecutive scrolls add up. Every other event, and the order between
+// events of different types, is kept. A coalesced event keeps the time of
+// the oldest event it replaces, so that latency is measured from the first
+// movement.
+
+class InputQueue final {
+public:
+  std::atomic<GLuint> Dropped; // events lost because the ring was full
+  GLuint Coalesced;            // events merged by drain()
+
+  explicit InputQueue(const size_t capacity = 1024); // rounded up to 2^n
+
+  InputQueue(const InputQueue &) = delete;
+  InputQueue &operator=(const InputQueue &) = delete;
+
+  size_t capacity() const;
+  bool empty() const;
+  bool push(const InputEvent &event);
+  bool pop(InputEvent &event);
+  void drain(std::vector<InputEvent> &batch);
+
+private:
+  std::unique_ptr<InputEvent[]> Events;
+  size_t Mask;
+  size_t Reserved; // slots only for events that cannot be coalesced
+  alignas(64) std::atomic<size_t> Head; // next event to write
+  alignas(64) std::atomic<size_t> Tail; // next event to read
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_INPUT_HPP */
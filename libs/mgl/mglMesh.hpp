@@ -0,0 +1,127 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Mesh Pool Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_MESH_HPP
+#define MGL_MESH_HPP
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "./mglVertexLayout.hpp"
+
+namespace mgl {
+
+struct Mesh;
+struct InstanceData;
+struct DrawElementsCommand;
+class MeshPool;
+
+/////////////////////////////////////////////////////////////////////////// Mesh
+
+struct Mesh {
+  GLint baseVertex;
+  GLuint firstIndex;
+  GLsizei count;
+};
+
+/////////////////////////////////////////////////////////////////// InstanceData
+//
+// Per-instance layout written by the mgl renderers into the instance binding.
+
+struct InstanceData {
+  glm::mat4 matrix;
+  glm::vec4 color;
+};
+
+//////////////////////////////////////////////////////////// DrawElementsCommand
+//
+// Layout of an indirect indexed draw, as read by glMultiDrawElementsIndirect.
+
+struct DrawElementsCommand {
+  GLuint count;
+  GLuint instanceCount;
+  GLuint firstIndex;
+  GLint baseVertex;
+  GLuint baseInstance;
+};
+
+/////////////////////////////////////////////////////////////////////// MeshPool
+//
+// Every mesh added to the pool is stored once in a single vertex buffer and a
+// single index buffer, shared by one VAO. Meshes are referred to by handles
+// (base vertex, first index, index count), so drawing different meshes only
+// changes the draw call parameters and never the bound GL objects.
+//
+// Vertex attributes use binding 0 and instance attributes binding 1, whose
+// buffer is provided by the caller with bindInstanceBuffer(). Both are
+// described by a VertexLayout, so vertices can use packed formats.
+//
+// Indices are relative to each mesh's base vertex. create() stores them with
+// the smallest type that holds the largest one: 8, 16 or 32 bits.
+
+class MeshPool final {
+public:
+  static const GLuint VERTEX_BINDING = 0;
+  static const GLuint INSTANCE_BINDING = 1;
+
+  GLuint VaoId;
+  GLuint BufferIds[2];
+  GLenum IndexType;
+  std::map<std::string, Mesh> Meshes;
+
+  MeshPool(const VertexLayout &vertex_layout,
+           const VertexLayout &instance_layout);
+  ~MeshPool();
+
+  MeshPool(const MeshPool &) = delete;
+  MeshPool &operator=(const MeshPool &) = delete;
+
+  const Mesh &addMesh(const std::string &name, const void *vertices,
+                      const GLsizei vertex_count, const GLuint *indices,
+                      const GLsizei index_count);
+  const Mesh &addMesh(const std::string &name, const void *vertices,
+                      const GLsizei vertex_count, const GLubyte *indices,
+                      const GLsizei index_count);
+  bool isMesh(const std::string &name);
+  void create();
+  void create(const void *vertices, const GLsizeiptr vertices_size,
+              const void *indices, const GLsizeiptr indices_size,
+              const GLenum index_type);
+  void readBuffers(std::vector<GLubyte> &vertices,
+                   std::vector<GLubyte> &indices) const;
+  GLsizei getVertexSize() const;
+  static GLuint getIndexSize(const GLenum index_type);
+  void bind();
+  void unbind();
+  void bindInstanceBuffer(const GLuint buffer_id, const GLsizei stride);
+  void draw(const Mesh &mesh);
+  void drawInstanced(const Mesh &mesh, const GLsizei instance_count,
+                     const GLuint base_instance);
+  void drawIndirect(const GLintptr offset, const GLsizei draw_count);
+
+private:
+  VertexLayout VertexAttributes;
+  VertexLayout InstanceAttributes;
+  GLsizei VertexSize;
+  GLsizei VertexCount;
+  GLuint IndexSize;
+  GLuint MaxIndex;
+  std::vector<GLubyte> VertexData;
+  std::vector<GLuint> IndexData;
+
+  GLvoid *indexOffset(const Mesh &mesh) const;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_MESH_HPP */
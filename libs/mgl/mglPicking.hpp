@@ -0,0 +1,106 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Picking Index Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_PICKING_HPP
+#define MGL_PICKING_HPP
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MGL_PICKING_SSE2 1
+#else
+#define MGL_PICKING_SSE2 0
+#endif
+
+namespace mgl {
+
+class PickingIndex;
+
+/////////////////////////////////////////////////////////////////// PickingIndex
+//
+// Answers "which item is under this point" on the CPU, without reading back
+// anything from the GPU. Items are instances of 2D shapes (triangle lists in
+// model space) placed by a matrix; only x and y of the world space result are
+// used, so points must be given in the same space as the matrices map to.
+//
+// Items are kept in a bounding volume hierarchy of axis aligned boxes with up
+// to LEAF_SIZE items per leaf. The world space triangles of each leaf are
+// stored contiguously in blocks of four, coordinate by coordinate, so that a
+// point is tested against four triangles at once (with SSE2).
+//
+// update() builds the hierarchy after items were added. Afterwards, changing
+// the matrix of an item only recomputes its triangles and refits the boxes on
+// the path to the root; the tree is not rebuilt, so items that move far from
+// their original neighbours make queries slower until the next build().
+//
+// When several items contain the point, the one added last is returned, as
+// it is the one drawn on top by painter's order.
+
+class PickingIndex final {
+public:
+  static const GLuint NONE = 0xFFFFFFFF;
+  static const GLuint LEAF_SIZE = 4;
+
+  GLuint Refitted; // items recomputed by the last update()
+
+  PickingIndex();
+
+  GLuint addShape(const glm::vec2 *vertices, const GLuint vertex_count);
+  GLuint addItem(const GLuint shape, const glm::mat4 &matrix);
+  void setMatrix(const GLuint item, const glm::mat4 &matrix);
+  GLuint size() const;
+  void clear();
+
+  void build();
+  void update();
+  GLuint pick(const glm::vec2 &point) const;
+
+private:
+  struct Node {
+    glm::vec2 min, max;
+    GLuint parent;
+    GLuint right; // 0 for leaves, the left child always follows its parent
+    GLuint firstItem, itemCount;
+    GLuint firstBlock, blockCount;
+  };
+  struct Block {
+    GLfloat x0[4], y0[4], x1[4], y1[4], x2[4], y2[4];
+    GLuint item[4];
+  };
+  struct Item {
+    GLuint shape;
+    GLuint leaf;
+    GLuint slot; // first triangle, as block * 4 + lane
+    bool dirty;
+    glm::vec2 min, max;
+  };
+
+  std::vector<glm::vec2> ShapeVertices;
+  std::vector<GLuint> ShapeFirst; // first vertex of each shape, plus the end
+  std::vector<Item> Items;
+  std::vector<glm::mat4> Matrices;
+  std::vector<GLuint> Dirty;
+  std::vector<GLuint> Order; // items in leaf order
+  std::vector<Node> Nodes;
+  std::vector<Block> Blocks;
+  bool Built;
+
+  GLuint buildNode(const GLuint parent, const GLuint first, const GLuint count);
+  void writeItem(const GLuint item);
+  void refitLeaf(const GLuint leaf);
+  GLuint pickLeaf(const Node &leaf, const glm::vec2 &point) const;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_PICKING_HPP */
@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Frame Profiler Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_PROFILER_HPP
+#define MGL_PROFILER_HPP
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace mgl {
+
+class FrameProfiler;
+
+////////////////////////////////////////////////////////////////// FrameProfiler
+//
+// Measures CPU time per frame phase and GPU time per frame. GPU time comes
+// from a ring of GL_TIME_ELAPSED queries whose results are only read once
+// available, so it arrives a few frames late but never blocks; frames for
+// which no query was free are counted in DroppedQueries.
+//
+// Percentiles are computed over the last WINDOW frames. When recording, all
+// frames are kept so they can be written to CSV or JSON at exit.
+
+class FrameProfiler final {
+public:
+  enum Phase { UPDATE, CLEAR, DISPLAY, SWAP, EVENTS, PHASES };
+  static const int WINDOW = 1024;
+  static const int QUERIES = 4;
+
+  struct Percentiles {
+    double p50, p95, p99;
+  };
+
+  GLuint DroppedQueries;
+
+  explicit FrameProfiler(bool record = false);
+  ~FrameProfiler();
+
+  FrameProfiler(const FrameProfiler &) = delete;
+  FrameProfiler &operator=(const FrameProfiler &) = delete;
+
+  void beginFrame();
+  void mark(const Phase phase);
+  void endGpu();
+  void endFrame();
+
+  Percentiles cpuPercentiles();
+  Percentiles gpuPercentiles();
+  Percentiles phasePercentiles(const Phase phase);
+  void report(std::ostream &out);
+  void write(const std::string &filename);
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  // Milliseconds per phase, then whole-frame CPU and GPU (-1 = pending)
+  enum Column { CPU = PHASES, GPU, COLUMNS };
+  struct FrameRecord {
+    double ms[COLUMNS];
+  };
+  std::deque<FrameRecord> Frames;
+  long FirstFrame;
+  long Frame;
+  bool Record;
+
+  GLuint Queries[QUERIES];
+  long QueryFrame[QUERIES];
+  int QueryNext;
+  int QueryActive;
+
+  Clock::time_point FrameStart;
+  Clock::time_point PhaseStart;
+  FrameRecord Current;
+
+  void collectQueries();
+  Percentiles percentiles(const int column);
+  void writeCsv(std::ostream &out);
+  void writeJson(std::ostream &out);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_PROFILER_HPP */
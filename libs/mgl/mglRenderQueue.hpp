@@ -0,0 +1,101 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Render Queue Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_RENDER_QUEUE_HPP
+#define MGL_RENDER_QUEUE_HPP
+
+#include <GL/glew.h>
+
+#include <functional>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "./mglMesh.hpp"
+#include "./mglShader.hpp"
+
+namespace mgl {
+
+struct DrawItem;
+class RenderQueue;
+
+/////////////////////////////////////////////////////////////////////// DrawItem
+
+struct DrawItem {
+  ShaderProgram *program;
+  Mesh mesh;
+  GLuint material; // application defined, 0 if unused
+  GLuint layer;    // 0 to 15, lower layers are drawn first
+  GLfloat depth;   // 0 to 1, nearer items are drawn first within a batch
+  InstanceData instance;
+};
+
+//////////////////////////////////////////////////////////////////// RenderQueue
+//
+// Collects the draw items of a frame and submits them in state order. Each
+// item gets a 64-bit key, most significant field first:
+//
+//   layer (4) | program (12) | material (16) | mesh (16) | depth (16)
+//
+// Programs and meshes are numbered in order of first use, so their keys stay
+// the same from frame to frame; a mesh is its whole range (base vertex, first
+// index and count), as meshes may share some of their indices. Keys are
+// radix sorted, which is stable, so items with equal keys keep their
+// submission order.
+//
+// Consecutive items sharing program, material and mesh become one instanced
+// draw; consecutive instanced draws sharing program and material become one
+// multi-draw when indirect drawing is available. The programs must take their
+// model matrix and color as instance attributes.
+
+class RenderQueue final {
+public:
+  typedef std::function<void(ShaderProgram *, GLuint)> MaterialCallback;
+
+  GLuint BufferIds[2]; // instance data, indirect commands
+  GLuint ItemCount;
+  GLuint DrawCalls;
+  GLuint ProgramChanges;
+
+  explicit RenderQueue(MeshPool *pool);
+  ~RenderQueue();
+
+  RenderQueue(const RenderQueue &) = delete;
+  RenderQueue &operator=(const RenderQueue &) = delete;
+
+  void setMaterialCallback(const MaterialCallback &callback);
+  void push(const DrawItem &item);
+  void submit();
+  void clear();
+
+private:
+  typedef std::pair<GLuint64, GLuint> KeyIndex;
+  typedef std::tuple<GLint, GLuint, GLsizei> MeshRange;
+
+  MeshPool *Pool;
+  MaterialCallback Material;
+  bool MultiDraw;
+  std::vector<DrawItem> Items;
+  std::vector<KeyIndex> Keys;
+  std::vector<KeyIndex> Scratch;
+  std::vector<InstanceData> Instances;
+  std::vector<DrawElementsCommand> Commands;
+  std::unordered_map<ShaderProgram *, GLuint> ProgramSlots;
+  std::map<MeshRange, GLuint> MeshSlots;
+
+  GLuint64 makeKey(const DrawItem &item);
+  void sort();
+  void draw(const size_t first, const size_t last);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_RENDER_QUEUE_HPP */
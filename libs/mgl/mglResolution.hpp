@@ -0,0 +1,92 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Dynamic Resolution Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_RESOLUTION_HPP
+#define MGL_RESOLUTION_HPP
+
+#include <GL/glew.h>
+
+#include <ostream>
+
+#include "./mglShader.hpp"
+
+namespace mgl {
+
+class DynamicResolution;
+
+////////////////////////////////////////////////////////////// DynamicResolution
+//
+// Renders the scene into an offscreen framebuffer at a fraction of the output
+// size and upscales it to the output. The framebuffer is allocated at the
+// full output size and the scene is drawn into its lower left corner, so the
+// scale can change every frame without reallocating anything.
+//
+// The scale is driven by the GPU time of the scene, measured with timestamp
+// queries (read a few frames late, never waiting for them) so that it can be
+// used together with the GL_TIME_ELAPSED queries of FrameProfiler. The cost
+// of a frame grows with its area, so the scale follows the square root of the
+// ratio between the budget and the measured time, moving only part of the
+// way every frame and ignoring changes under a percent.
+//
+// BILINEAR upscaling is a linear blit. EDGE_AWARE upscaling runs a program
+// that weighs the four texels around each output pixel by how close they are
+// in luminance to the nearest one, so that smooth areas are interpolated and
+// edges stay sharp; it needs a program with a full screen vertex shader and
+// the SourceSize and TextureSize uniforms, and falls back to the blit until
+// that program is ready.
+
+class DynamicResolution final {
+public:
+  enum Filter { BILINEAR, EDGE_AWARE };
+  static const int QUERIES = 4;
+
+  double TargetMs;    // GPU time budget of the scene
+  GLfloat MinScale;   // of each axis
+  GLfloat MaxScale;
+  GLfloat Gain;       // fraction of the correction applied per frame
+  Filter Upscale;
+  GLfloat Scale;      // current
+  double GpuMs;       // last measured scene time, -1 until known
+  GLuint DroppedQueries;
+
+  DynamicResolution(const double target_ms, const Filter filter = BILINEAR,
+                    ShaderProgram *program = nullptr);
+  ~DynamicResolution();
+
+  DynamicResolution(const DynamicResolution &) = delete;
+  DynamicResolution &operator=(const DynamicResolution &) = delete;
+
+  void begin(const GLsizei width, const GLsizei height);
+  void end(const GLuint target);
+  GLsizei getWidth() const;
+  GLsizei getHeight() const;
+  void report(std::ostream &out) const;
+
+private:
+  ShaderProgram *Program;
+  UniformHandle SourceSizeId, TextureSizeId;
+  GLuint Framebuffer, Texture, Depthbuffer, VertexArray;
+  GLsizei OutputWidth, OutputHeight;
+  GLsizei Width, Height;
+  GLuint Queries[QUERIES][2];
+  bool QueryPending[QUERIES];
+  int QueryNext;
+  int QueryActive;
+  long Frames;
+  double ScaleSum;
+  GLfloat ScaleMin, ScaleMax;
+
+  void allocate();
+  void collectQueries();
+  void adjust(const double gpu_ms);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_RESOLUTION_HPP */
@@ -0,0 +1,171 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Binary Scene File Classes
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_SCENE_HPP
+#define MGL_SCENE_HPP
+
+#include <GL/glew.h>
+
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "./mglMesh.hpp"
+
+namespace mgl {
+
+struct SceneHeader;
+struct SceneSection;
+struct SceneMesh;
+class SceneFile;
+class SceneStream;
+class SceneWriter;
+
+//////////////////////////////////////////////////////////////////// FILE LAYOUT
+//
+// A header, a table of sections, then the data of each section starting at a
+// multiple of SCENE_ALIGNMENT. All values are little endian and stored exactly
+// as OpenGL consumes them, so sections can be handed to the GL straight from
+// a mapping of the file:
+//
+//   VERTICES   vertex buffer, format = vertex stride
+//   INDICES    index buffer, format = GL index type
+//   MESHES     SceneMesh records, format = sizeof(SceneMesh)
+//   INSTANCES  InstanceData records, format = sizeof(InstanceData)
+//
+// Instances are grouped by mesh; each mesh record gives its range.
+
+const char SCENE_MAGIC[4] = {'M', 'G', 'L', 'S'};
+const GLuint SCENE_VERSION = 1;
+const GLuint64 SCENE_ALIGNMENT = 256;
+
+enum class SceneSectionType : GLuint {
+  VERTICES = 1,
+  INDICES = 2,
+  MESHES = 3,
+  INSTANCES = 4
+};
+
+struct SceneHeader {
+  char magic[4];
+  GLuint version;
+  GLuint sectionCount;
+  GLuint reserved;
+};
+
+struct SceneSection {
+  SceneSectionType type;
+  GLuint format;
+  GLuint64 offset;
+  GLuint64 size;
+  GLuint64 count;
+};
+
+struct SceneMesh {
+  char name[48];
+  GLint baseVertex;
+  GLuint firstIndex;
+  GLuint count;
+  GLuint firstInstance;
+  GLuint instanceCount;
+  GLuint reserved[3];
+};
+
+////////////////////////////////////////////////////////////////////// SceneFile
+//
+// Memory maps a whole scene file. Nothing is copied: meshes and instances are
+// uploaded from the mapping itself. Opening only reads the section table and
+// the mesh records, and rejects files whose meshes reach past the sections.
+
+class SceneFile final {
+public:
+  explicit SceneFile(const std::string &filename);
+  ~SceneFile();
+
+  SceneFile(const SceneFile &) = delete;
+  SceneFile &operator=(const SceneFile &) = delete;
+
+  bool hasSection(const SceneSectionType type) const;
+  const SceneSection &getSection(const SceneSectionType type) const;
+  const void *getData(const SceneSectionType type) const;
+  const SceneMesh *getMeshes() const;
+  GLuint getMeshCount() const;
+
+  void createMeshPool(MeshPool &pool) const;
+  void createInstanceBuffer(const GLuint buffer_id) const;
+
+private:
+  const GLubyte *Data;
+  size_t Size;
+  const SceneSection *Sections;
+  GLuint SectionCount;
+#ifdef _WIN32
+  void *FileHandle;
+  void *MappingHandle;
+#endif
+
+  void map(const std::string &filename);
+  void unmap();
+};
+
+//////////////////////////////////////////////////////////////////// SceneStream
+//
+// Reads a scene file in chunks of CHUNK_SIZE bytes, so files larger than the
+// available memory can be loaded. upload() reads each chunk directly into a
+// mapped range of the GL buffer. The mesh records are checked as by SceneFile.
+
+class SceneStream final {
+public:
+  static const size_t CHUNK_SIZE = 4 << 20;
+
+  explicit SceneStream(const std::string &filename);
+
+  const std::vector<SceneSection> &getSections() const;
+  const SceneSection &getSection(const SceneSectionType type) const;
+  void read(const SceneSectionType type,
+            const std::function<void(const GLubyte *, size_t)> &consumer);
+  void upload(const SceneSectionType type, const GLenum target,
+              const GLuint buffer_id);
+
+private:
+  std::ifstream File;
+  std::vector<SceneSection> Sections;
+  std::vector<GLubyte> Chunk;
+};
+
+//////////////////////////////////////////////////////////////////// SceneWriter
+
+class SceneWriter final {
+public:
+  void setVertices(const void *data, const GLuint64 size, const GLuint stride);
+  void setIndices(const void *data, const GLuint64 size,
+                  const GLenum index_type);
+  void setInstances(const InstanceData *data, const GLuint count);
+  void addMesh(const std::string &name, const Mesh &mesh,
+               const GLuint first_instance, const GLuint instance_count);
+  void write(const std::string &filename) const;
+
+private:
+  struct Blob {
+    SceneSectionType type;
+    GLuint format;
+    const void *data;
+    GLuint64 size;
+    GLuint64 count;
+  };
+  std::vector<Blob> Blobs;
+  std::vector<SceneMesh> Meshes;
+
+  void setBlob(const Blob &blob);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_SCENE_HPP */
@@ -8,27 +8,43 @@
 
 #include "./mglShader.hpp"
 
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <glm/gtc/type_ptr.hpp>
 #include <iostream>
 #include <vector>
 
+#include "./mglState.hpp"
+
 namespace mgl {
 
 ////////////////////////////////////////////////////////////////// ShaderProgram
 
 const std::string ShaderProgram::read(const std::string &filename) {
-  std::string line, shader_string;
-  std::ifstream ifile(filename);
+  std::ifstream ifile(filename, std::ios::binary | std::ios::ate);
   if (!ifile.is_open()) {
     std::cerr << "[ERROR] Failed to open shader file: " << filename;
     throw std::runtime_error("Failed to open shader file.");
   }
-  while (std::getline(ifile, line)) {
-    shader_string += line + "\n";
-  }
+  std::string shader_string(static_cast<size_t>(ifile.tellg()), '\0');
+  ifile.seekg(0);
+  ifile.read(&shader_string[0], shader_string.size());
   return shader_string;
 }
 
+void ShaderProgram::compile() {
+  for (auto &i : Sources) {
+    const GLuint shader_id = glCreateShader(i.first);
+    const GLchar *code = i.second.code.c_str();
+    glShaderSource(shader_id, 1, &code, 0);
+    glCompileShader(shader_id);
+    glAttachShader(ProgramId, shader_id);
+    Shaders[i.first] = {shader_id};
+  }
+}
+
 void ShaderProgram::checkCompilation(const GLuint shader_id,
                                      const std::string &filename) {
   GLint compiled;
@@ -56,24 +72,20 @@ void ShaderProgram::checkLinkage() {
   }
 }
 
-ShaderProgram::ShaderProgram() : ProgramId(glCreateProgram()) {}
+ShaderProgram::ShaderProgram()
+    : ProgramId(glCreateProgram()), UniformsIssued(0), UniformsSkipped(0),
+      Ready(false) {}
 
 ShaderProgram::~ShaderProgram() {
-  glUseProgram(0);
+  StateCache::getInstance().forgetProgram(ProgramId);
   glDeleteProgram(ProgramId);
 }
 
+// Compilation is deferred to create(), where it can be skipped altogether
+// if the binary cache holds a matching program.
 void ShaderProgram::addShader(const GLenum shader_type,
                               const std::string &filename) {
-  const GLuint shader_id = glCreateShader(shader_type);
-  const std::string scode = read(filename);
-  const GLchar *code = scode.c_str();
-  glShaderSource(shader_id, 1, &code, 0);
-  glCompileShader(shader_id);
-  checkCompilation(shader_id, filename);
-  glAttachShader(ProgramId, shader_id);
-
-  Shaders[shader_type] = {shader_id};
+  Sources[shader_type] = {filename, read(filename)};
 }
 
 void ShaderProgram::addAttribute(const std::string &name, const GLuint index) {
@@ -92,14 +104,26 @@ bool ShaderProgram::isAttribute(const std::string &name) {
 void ShaderProgram::addUniform(const std::string &name) {
   if (isUniform(name)) {
     std::cerr << "[WARNING] Uniform " << name << " already exists" << std::endl;
+    return;
   }
-  Uniforms[name] = {-1};
+  UniformHandle handle = {static_cast<GLuint>(UniformCaches.size())};
+  UniformCaches.push_back({-1, 0, {}});
+  Uniforms[name] = {-1, handle};
 }
 
 bool ShaderProgram::isUniform(const std::string &name) {
   return Uniforms.find(name) != Uniforms.end();
 }
 
+UniformHandle ShaderProgram::getUniformHandle(const std::string &name) {
+  auto i = Uniforms.find(name);
+  if (i == Uniforms.end()) {
+    std::cerr << "[ERROR] Uniform " << name << " was never added" << std::endl;
+    throw std::runtime_error("Unknown uniform.");
+  }
+  return i->second.handle;
+}
+
 void ShaderProgram::addUniformBlock(const std::string &name,
                                     const GLuint binding_point) {
   if (isUniformBlock(name)) {
@@ -114,17 +138,65 @@ bool ShaderProgram::isUniformBlock(const std::string &name) {
 }
 
 void ShaderProgram::create() {
-  glLinkProgram(ProgramId);
+  createAsync();
+  finalize();
+}
+
+// Submits compilation and linking without waiting for either; with
+// KHR_parallel_shader_compile the driver works on them in the background.
+void ShaderProgram::createAsync() {
+  CacheFile = CacheDirectory.empty() ? "" : cacheFilename();
+  if (!CacheFile.empty() && loadBinary(CacheFile)) {
+    CacheHits++;
+    CacheFile.clear();
+  } else {
+    compile();
+    if (!CacheFile.empty()) {
+      CacheMisses++;
+      glProgramParameteri(ProgramId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                          GL_TRUE);
+    }
+    glLinkProgram(ProgramId);
+  }
+  Ready = false;
+}
+
+// Never blocks. Without the parallel compile extension there is no way to
+// ask, so the program is reported ready and waited for on first bind().
+bool ShaderProgram::isReady() {
+  if (Ready)
+    return true;
+  if (GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile) {
+    GLint completed = GL_FALSE;
+    glGetProgramiv(ProgramId, GL_COMPLETION_STATUS_KHR, &completed);
+    if (completed == GL_FALSE)
+      return false;
+    finalize();
+  }
+  return true;
+}
+
+void ShaderProgram::finalize() {
+  GLint linked;
+  glGetProgramiv(ProgramId, GL_LINK_STATUS, &linked);
+  if (linked == GL_FALSE) {
+    for (auto &i : Shaders)
+      checkCompilation(i.second, Sources[i.first].filename);
+  }
   checkLinkage();
   for (auto &i : Shaders) {
     glDetachShader(ProgramId, i.second);
     glDeleteShader(i.second);
   }
+  Shaders.clear();
+  if (!CacheFile.empty())
+    saveBinary(CacheFile);
 
   for (auto &i : Uniforms) {
     i.second.index = glGetUniformLocation(ProgramId, i.first.c_str());
     if (i.second.index < 0)
       std::cerr << "WARNING: Uniform " << i.first << " not found." << std::endl;
+    UniformCaches[i.second.handle.slot] = {i.second.index, 0, {}};
   }
   for (auto &i : Ubos) {
     i.second.index = glGetUniformBlockIndex(ProgramId, i.first.c_str());
@@ -132,11 +204,170 @@ void ShaderProgram::create() {
       std::cerr << "WARNING: UBO " << i.first << " not found." << std::endl;
     glUniformBlockBinding(ProgramId, i.second.index, i.second.binding_point);
   }
+  Ready = true;
+}
+
+void ShaderProgram::bind() {
+  if (!Ready)
+    finalize();
+  StateCache::getInstance().useProgram(ProgramId);
 }
 
-void ShaderProgram::bind() { glUseProgram(ProgramId); }
+void ShaderProgram::unbind() { StateCache::getInstance().useProgram(0); }
+
+//////////////////////////////////////////////////////////////// UNIFORM CACHE
+
+bool ShaderProgram::cacheUniform(const UniformHandle handle, const void *value,
+                                 const GLsizei size) {
+  UniformCache &cache = UniformCaches[handle.slot];
+  if (cache.size == size && std::memcmp(cache.value, value, size) == 0) {
+    UniformsSkipped++;
+    return false;
+  }
+  std::memcpy(cache.value, value, size);
+  cache.size = size;
+  UniformsIssued++;
+  return true;
+}
+
+void ShaderProgram::setUniform(const UniformHandle handle, const GLint value) {
+  if (cacheUniform(handle, &value, sizeof(value)))
+    glUniform1i(UniformCaches[handle.slot].location, value);
+}
+
+void ShaderProgram::setUniform(const UniformHandle handle,
+                               const GLfloat value) {
+  if (cacheUniform(handle, &value, sizeof(value)))
+    glUniform1f(UniformCaches[handle.slot].location, value);
+}
 
-void ShaderProgram::unbind() { glUseProgram(0); }
+void ShaderProgram::setUniform(const UniformHandle handle,
+                               const glm::vec2 &value) {
+  if (cacheUniform(handle, glm::value_ptr(value), sizeof(value)))
+    glUniform2fv(UniformCaches[handle.slot].location, 1,
+                 glm::value_ptr(value));
+}
+
+void ShaderProgram::setUniform(const UniformHandle handle,
+                               const glm::vec3 &value) {
+  if (cacheUniform(handle, glm::value_ptr(value), sizeof(value)))
+    glUniform3fv(UniformCaches[handle.slot].location, 1,
+                 glm::value_ptr(value));
+}
+
+void ShaderProgram::setUniform(const UniformHandle handle,
+                               const glm::vec4 &value) {
+  if (cacheUniform(handle, glm::value_ptr(value), sizeof(value)))
+    glUniform4fv(UniformCaches[handle.slot].location, 1,
+                 glm::value_ptr(value));
+}
+
+void ShaderProgram::setUniform(const UniformHandle handle,
+                               const glm::mat3 &value) {
+  if (cacheUniform(handle, glm::value_ptr(value), sizeof(value)))
+    glUniformMatrix3fv(UniformCaches[handle.slot].location, 1, GL_FALSE,
+                       glm::value_ptr(value));
+}
+
+void ShaderProgram::setUniform(const UniformHandle handle,
+                               const glm::mat4 &value) {
+  if (cacheUniform(handle, glm::value_ptr(value), sizeof(value)))
+    glUniformMatrix4fv(UniformCaches[handle.slot].location, 1, GL_FALSE,
+                       glm::value_ptr(value));
+}
+
+void ShaderProgram::resetUniformStats() {
+  UniformsIssued = 0;
+  UniformsSkipped = 0;
+}
+
+///////////////////////////////////////////////////////////////// BINARY CACHE
+
+GLuint ShaderProgram::CacheHits = 0;
+GLuint ShaderProgram::CacheMisses = 0;
+std::string ShaderProgram::CacheDirectory;
+
+// Linked programs are stored in the directory (created if needed) and reused
+// by later runs instead of compiling. An empty directory disables the cache.
+void ShaderProgram::setBinaryCache(const std::string &directory) {
+  CacheDirectory = directory;
+  if (!directory.empty()) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+  }
+}
+
+// FNV-1a over everything that changes the linked binary: stage sources,
+// attribute bindings and the driver that produced it.
+const std::string ShaderProgram::cacheFilename() {
+  GLuint64 hash = 14695981039346656037ULL;
+  auto add = [&hash](const void *data, size_t size) {
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; i++) {
+      hash ^= bytes[i];
+      hash *= 1099511628211ULL;
+    }
+  };
+  for (auto &i : Sources) {
+    add(&i.first, sizeof(i.first));
+    add(i.second.code.data(), i.second.code.size());
+  }
+  for (auto &i : Attributes) {
+    add(i.first.data(), i.first.size());
+    add(&i.second.index, sizeof(i.second.index));
+  }
+  for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+    const char *value = reinterpret_cast<const char *>(glGetString(name));
+    if (value)
+      add(value, std::strlen(value));
+  }
+  char filename[32];
+  std::snprintf(filename, sizeof(filename), "%016llx.bin",
+                static_cast<unsigned long long>(hash));
+  return CacheDirectory + "/" + filename;
+}
+
+// A missing, truncated or rejected binary is a miss, never an error
+bool ShaderProgram::loadBinary(const std::string &filename) {
+  std::ifstream ifile(filename, std::ios::binary);
+  if (!ifile.is_open())
+    return false;
+  GLenum format = 0;
+  GLint length = 0;
+  ifile.read(reinterpret_cast<char *>(&format), sizeof(format));
+  ifile.read(reinterpret_cast<char *>(&length), sizeof(length));
+  if (!ifile || length <= 0)
+    return false;
+  std::vector<char> binary(length);
+  ifile.read(binary.data(), length);
+  if (!ifile)
+    return false;
+
+  glProgramBinary(ProgramId, format, binary.data(), length);
+  GLint linked = GL_FALSE;
+  glGetProgramiv(ProgramId, GL_LINK_STATUS, &linked);
+  return linked == GL_TRUE;
+}
+
+void ShaderProgram::saveBinary(const std::string &filename) {
+  GLint length = 0;
+  glGetProgramiv(ProgramId, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return; // driver without binary formats
+  std::vector<char> binary(length);
+  GLenum format = 0;
+  glGetProgramBinary(ProgramId, length, &length, &format, binary.data());
+
+  std::ofstream ofile(filename, std::ios::binary);
+  if (!ofile.is_open()) {
+    std::cerr << "[WARNING] Failed to write shader cache file: " << filename
+              << std::endl;
+    return;
+  }
+  ofile.write(reinterpret_cast<const char *>(&format), sizeof(format));
+  ofile.write(reinterpret_cast<const char *>(&length), sizeof(length));
+  ofile.write(binary.data(), length);
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 } // namespace mgl
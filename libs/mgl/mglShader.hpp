@@ -11,13 +11,22 @@
 
 #include <GL/glew.h>
 
+#include <glm/glm.hpp>
 #include <map>
 #include <string>
+#include <vector>
 
 namespace mgl {
 
+struct UniformHandle;
 class ShaderProgram;
 
+////////////////////////////////////////////////////////////////// UniformHandle
+
+struct UniformHandle {
+  GLuint slot;
+};
+
 ////////////////////////////////////////////////////////////////// ShaderProgram
 
 class ShaderProgram final {
@@ -36,6 +45,7 @@ public:
 
   struct UniformInfo {
     GLint index;
+    UniformHandle handle;
   };
   std::map<std::string, UniformInfo> Uniforms;
 
@@ -45,6 +55,13 @@ public:
   };
   std::map<std::string, UboInfo> Ubos;
 
+  GLuint UniformsIssued;
+  GLuint UniformsSkipped;
+
+  static GLuint CacheHits;
+  static GLuint CacheMisses;
+  static void setBinaryCache(const std::string &directory);
+
   ShaderProgram();
   ~ShaderProgram();
 
@@ -58,16 +75,53 @@ public:
   bool isAttribute(const std::string &name);
   void addUniform(const std::string &name);
   bool isUniform(const std::string &name);
+  UniformHandle getUniformHandle(const std::string &name);
   void addUniformBlock(const std::string &name, const GLuint binding_point);
   bool isUniformBlock(const std::string &name);
   void create();
+  void createAsync();
+  bool isReady();
   void bind();
   void unbind();
 
+  // The program must be bound. Values equal to the last upload are skipped.
+  void setUniform(const UniformHandle handle, const GLint value);
+  void setUniform(const UniformHandle handle, const GLfloat value);
+  void setUniform(const UniformHandle handle, const glm::vec2 &value);
+  void setUniform(const UniformHandle handle, const glm::vec3 &value);
+  void setUniform(const UniformHandle handle, const glm::vec4 &value);
+  void setUniform(const UniformHandle handle, const glm::mat3 &value);
+  void setUniform(const UniformHandle handle, const glm::mat4 &value);
+  void resetUniformStats();
+
 private:
+  static std::string CacheDirectory;
+  std::string CacheFile;
+  bool Ready;
+
+  struct SourceInfo {
+    std::string filename;
+    std::string code;
+  };
+  std::map<GLenum, SourceInfo> Sources;
+
+  struct UniformCache {
+    GLint location;
+    GLsizei size;
+    GLubyte value[sizeof(glm::mat4)];
+  };
+  std::vector<UniformCache> UniformCaches;
+
+  bool cacheUniform(const UniformHandle handle, const void *value,
+                    const GLsizei size);
   const std::string read(const std::string &filename);
+  void compile();
+  void finalize();
   void checkCompilation(const GLuint shader_id, const std::string &filename);
   void checkLinkage();
+  const std::string cacheFilename();
+  bool loadBinary(const std::string &filename);
+  void saveBinary(const std::string &filename);
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,328 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// OpenGL State Cache
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglState.hpp"
+
+namespace mgl {
+
+// Shadow value for state that has not been set through the cache yet
+static const GLuint UNKNOWN = 0xFFFFFFFF;
+
+///////////////////////////////////////////////////////////////////// StateCache
+
+StateCache::StateCache()
+    : Issued(0), Elided(0), LastIssued(0), LastElided(0) {
+  invalidate();
+}
+
+StateCache &StateCache::getInstance() {
+  static StateCache instance;
+  return instance;
+}
+
+void StateCache::invalidate() {
+  Program = {UNKNOWN, UNKNOWN};
+  VertexArray = {UNKNOWN, UNKNOWN};
+  Buffers.clear();
+  IndexedBuffers.clear();
+  Textures.clear();
+  ActiveUnit = UNKNOWN;
+  ReadFramebuffer = DrawFramebuffer = UNKNOWN;
+  Caps.clear();
+  BlendFunc[0] = BlendFunc[1] = UNKNOWN;
+  DepthFunc = UNKNOWN;
+  DepthMask = -1;
+  CullFace = UNKNOWN;
+  Viewport[0] = Viewport[1] = Viewport[2] = Viewport[3] = -1;
+  Scissor[0] = Scissor[1] = Scissor[2] = Scissor[3] = -1;
+}
+
+void StateCache::endFrame() {
+  LastIssued = Issued;
+  LastElided = Elided;
+  Issued = Elided = 0;
+}
+
+/////////////////////////////////////////////////////////////////////// BINDING
+
+// Returns whether the bind has to be issued now
+bool StateCache::bind(Binding &binding, const GLuint id) {
+  if (binding.desired != binding.actual)
+    Elided++; // pending unbind that never reaches the driver
+  binding.desired = id;
+  if (id == binding.actual) {
+    Elided++;
+    return false;
+  }
+  if (id == 0)
+    return false; // deferred until flush() or overridden
+  binding.actual = id;
+  Issued++;
+  return true;
+}
+
+void StateCache::useProgram(const GLuint program) {
+  if (bind(Program, program))
+    glUseProgram(program);
+}
+
+void StateCache::bindVertexArray(const GLuint vao) {
+  if (bind(VertexArray, vao))
+    glBindVertexArray(vao);
+}
+
+void StateCache::bindBuffer(const GLenum target, const GLuint buffer) {
+  if (target == GL_ELEMENT_ARRAY_BUFFER) {
+    // Part of the bound VAO, which must really be the intended one
+    flushVertexArray();
+    Issued++;
+    glBindBuffer(target, buffer);
+    return;
+  }
+  auto i = Buffers.find(target);
+  if (i == Buffers.end())
+    i = Buffers.insert({target, {UNKNOWN, UNKNOWN}}).first;
+  if (bind(i->second, buffer))
+    glBindBuffer(target, buffer);
+  else if (target == GL_PIXEL_PACK_BUFFER || target == GL_PIXEL_UNPACK_BUFFER)
+    flushBuffer(target, i->second); // pixel transfers read it, never defer
+}
+
+// Returns whether the indexed bind has to be issued now
+bool StateCache::bindIndexed(const GLenum target, const GLuint index,
+                             const IndexedBinding &binding) {
+  IndexedBinding &bound =
+      IndexedBuffers.insert({{target, index}, {UNKNOWN, 0, 0}}).first->second;
+  if (bound.buffer == binding.buffer && bound.offset == binding.offset &&
+      bound.size == binding.size) {
+    Elided++;
+    return false;
+  }
+  bound = binding;
+  Buffers[target] = {binding.buffer, binding.buffer};
+  Issued++;
+  return true;
+}
+
+void StateCache::bindBufferBase(const GLenum target, const GLuint index,
+                                const GLuint buffer) {
+  if (bindIndexed(target, index, {buffer, 0, 0}))
+    glBindBufferBase(target, index, buffer);
+}
+
+void StateCache::bindBufferRange(const GLenum target, const GLuint index,
+                                 const GLuint buffer, const GLintptr offset,
+                                 const GLsizeiptr size) {
+  if (bindIndexed(target, index, {buffer, offset, size}))
+    glBindBufferRange(target, index, buffer, offset, size);
+}
+
+void StateCache::bindTexture(const GLuint unit, const GLenum target,
+                             const GLuint texture) {
+  GLuint &bound = Textures.insert({{unit, target}, UNKNOWN}).first->second;
+  if (bound == texture) {
+    Elided++;
+    return;
+  }
+  if (ActiveUnit != unit) {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    ActiveUnit = unit;
+    Issued++;
+  }
+  glBindTexture(target, texture);
+  bound = texture;
+  Issued++;
+}
+
+void StateCache::bindFramebuffer(const GLenum target,
+                                 const GLuint framebuffer) {
+  const bool read = target != GL_DRAW_FRAMEBUFFER;
+  const bool draw = target != GL_READ_FRAMEBUFFER;
+  if ((!read || ReadFramebuffer == framebuffer) &&
+      (!draw || DrawFramebuffer == framebuffer)) {
+    Elided++;
+    return;
+  }
+  glBindFramebuffer(target, framebuffer);
+  if (read)
+    ReadFramebuffer = framebuffer;
+  if (draw)
+    DrawFramebuffer = framebuffer;
+  Issued++;
+}
+
+///////////////////////////////////////////////////////////////////////// FLUSH
+
+void StateCache::flushProgram() {
+  if (Program.desired != Program.actual) {
+    glUseProgram(Program.desired);
+    Program.actual = Program.desired;
+    Issued++;
+  }
+}
+
+void StateCache::flushVertexArray() {
+  if (VertexArray.desired != VertexArray.actual) {
+    glBindVertexArray(VertexArray.desired);
+    VertexArray.actual = VertexArray.desired;
+    Issued++;
+  }
+}
+
+void StateCache::flushBuffer(const GLenum target, Binding &binding) {
+  if (binding.desired != binding.actual) {
+    glBindBuffer(target, binding.desired);
+    binding.actual = binding.desired;
+    Issued++;
+  }
+}
+
+void StateCache::flush() {
+  flushProgram();
+  flushVertexArray();
+  for (auto &i : Buffers)
+    flushBuffer(i.first, i.second);
+}
+
+// Deleted objects must not be mistaken for bound ones once their names are
+// reused; deleting a bound object also unbinds it in GL.
+void StateCache::forgetProgram(const GLuint program) {
+  if (Program.actual == program)
+    Program = {UNKNOWN, UNKNOWN};
+}
+
+void StateCache::forgetVertexArray(const GLuint vao) {
+  if (VertexArray.actual == vao)
+    VertexArray = {0, 0};
+}
+
+void StateCache::forgetBuffer(const GLuint buffer) {
+  for (auto &i : Buffers) {
+    if (i.second.actual == buffer)
+      i.second = {0, 0};
+  }
+  for (auto &i : IndexedBuffers) {
+    if (i.second.buffer == buffer)
+      i.second = {0, 0, 0};
+  }
+}
+
+void StateCache::forgetTexture(const GLuint texture) {
+  for (auto &i : Textures) {
+    if (i.second == texture)
+      i.second = 0;
+  }
+}
+
+void StateCache::forgetFramebuffer(const GLuint framebuffer) {
+  if (ReadFramebuffer == framebuffer)
+    ReadFramebuffer = 0;
+  if (DrawFramebuffer == framebuffer)
+    DrawFramebuffer = 0;
+}
+
+///////////////////////////////////////////////////////////////// FIXED STATE
+
+void StateCache::setCap(const GLenum cap, const GLboolean enabled) {
+  auto i = Caps.find(cap);
+  if (i != Caps.end() && i->second == enabled) {
+    Elided++;
+    return;
+  }
+  if (enabled)
+    glEnable(cap);
+  else
+    glDisable(cap);
+  Caps[cap] = enabled;
+  Issued++;
+}
+
+void StateCache::enable(const GLenum cap) { setCap(cap, GL_TRUE); }
+
+void StateCache::disable(const GLenum cap) { setCap(cap, GL_FALSE); }
+
+bool StateCache::isEnabled(const GLenum cap) {
+  auto i = Caps.find(cap);
+  if (i == Caps.end())
+    i = Caps.insert({cap, glIsEnabled(cap)}).first;
+  return i->second == GL_TRUE;
+}
+
+void StateCache::blendFunc(const GLenum sfactor, const GLenum dfactor) {
+  if (BlendFunc[0] == sfactor && BlendFunc[1] == dfactor) {
+    Elided++;
+    return;
+  }
+  glBlendFunc(sfactor, dfactor);
+  BlendFunc[0] = sfactor;
+  BlendFunc[1] = dfactor;
+  Issued++;
+}
+
+void StateCache::depthFunc(const GLenum func) {
+  if (DepthFunc == func) {
+    Elided++;
+    return;
+  }
+  glDepthFunc(func);
+  DepthFunc = func;
+  Issued++;
+}
+
+void StateCache::depthMask(const GLboolean flag) {
+  if (DepthMask == flag) {
+    Elided++;
+    return;
+  }
+  glDepthMask(flag);
+  DepthMask = flag;
+  Issued++;
+}
+
+void StateCache::cullFace(const GLenum mode) {
+  if (CullFace == mode) {
+    Elided++;
+    return;
+  }
+  glCullFace(mode);
+  CullFace = mode;
+  Issued++;
+}
+
+void StateCache::viewport(const GLint x, const GLint y, const GLsizei width,
+                          const GLsizei height) {
+  if (Viewport[0] == x && Viewport[1] == y && Viewport[2] == width &&
+      Viewport[3] == height) {
+    Elided++;
+    return;
+  }
+  glViewport(x, y, width, height);
+  Viewport[0] = x;
+  Viewport[1] = y;
+  Viewport[2] = width;
+  Viewport[3] = height;
+  Issued++;
+}
+
+void StateCache::scissor(const GLint x, const GLint y, const GLsizei width,
+                         const GLsizei height) {
+  if (Scissor[0] == x && Scissor[1] == y && Scissor[2] == width &&
+      Scissor[3] == height) {
+    Elided++;
+    return;
+  }
+  glScissor(x, y, width, height);
+  Scissor[0] = x;
+  Scissor[1] = y;
+  Scissor[2] = width;
+  Scissor[3] = height;
+  Issued++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
@@ -0,0 +1,125 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// OpenGL State Cache
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_STATE_HPP
+#define MGL_STATE_HPP
+
+#include <GL/glew.h>
+
+#include <map>
+#include <utility>
+
+namespace mgl {
+
+class StateCache;
+
+///////////////////////////////////////////////////////////////////// StateCache
+//
+// Shadows the bound program, VAO, buffers, textures and framebuffers and the
+// blend, depth, cull, viewport and scissor state of the current context, and
+// only forwards calls that actually change something. Every call is counted
+// as issued or elided.
+//
+// Unbinding a program, VAO or buffer (binding 0) is deferred: if the same
+// object is bound again before anything else, neither call reaches the
+// driver. flush() issues pending unbinds; binding an element array buffer
+// flushes the VAO first, since that binding is VAO state. Pixel pack and
+// unpack buffers are unbound at once, as they change what the pointers given
+// to glReadPixels() or glTexImage2D() mean. Indexed bindings
+// (uniform, shader storage, atomic counter), whole or ranges, also set the
+// generic binding of their target, as in GL. Binding GL_FRAMEBUFFER sets both
+// the read and the draw framebuffer. isEnabled() queries GL only for
+// capabilities not set through the cache yet.
+//
+// All GL state changes must go through the cache, or invalidate() must be
+// called afterwards.
+
+class StateCache final {
+public:
+  GLuint Issued, Elided;         // current frame
+  GLuint LastIssued, LastElided; // previous frame
+
+  static StateCache &getInstance();
+
+  void useProgram(const GLuint program);
+  void bindVertexArray(const GLuint vao);
+  void bindBuffer(const GLenum target, const GLuint buffer);
+  void bindBufferBase(const GLenum target, const GLuint index,
+                      const GLuint buffer);
+  void bindBufferRange(const GLenum target, const GLuint index,
+                       const GLuint buffer, const GLintptr offset,
+                       const GLsizeiptr size);
+  void bindTexture(const GLuint unit, const GLenum target,
+                   const GLuint texture);
+  void bindFramebuffer(const GLenum target, const GLuint framebuffer);
+  void enable(const GLenum cap);
+  void disable(const GLenum cap);
+  bool isEnabled(const GLenum cap);
+  void blendFunc(const GLenum sfactor, const GLenum dfactor);
+  void depthFunc(const GLenum func);
+  void depthMask(const GLboolean flag);
+  void cullFace(const GLenum mode);
+  void viewport(const GLint x, const GLint y, const GLsizei width,
+                const GLsizei height);
+  void scissor(const GLint x, const GLint y, const GLsizei width,
+               const GLsizei height);
+
+  void forgetProgram(const GLuint program);
+  void forgetVertexArray(const GLuint vao);
+  void forgetBuffer(const GLuint buffer);
+  void forgetTexture(const GLuint texture);
+  void forgetFramebuffer(const GLuint framebuffer);
+
+  void flush();
+  void invalidate();
+  void endFrame();
+
+private:
+  StateCache();
+
+  struct Binding {
+    GLuint desired;
+    GLuint actual;
+  };
+  struct IndexedBinding {
+    GLuint buffer;
+    GLintptr offset;
+    GLsizeiptr size; // 0 for the whole buffer
+  };
+  Binding Program;
+  Binding VertexArray;
+  std::map<GLenum, Binding> Buffers;
+  std::map<std::pair<GLenum, GLuint>, IndexedBinding> IndexedBuffers;
+  std::map<std::pair<GLuint, GLenum>, GLuint> Textures;
+  GLuint ActiveUnit;
+  GLuint ReadFramebuffer, DrawFramebuffer;
+  std::map<GLenum, GLboolean> Caps;
+  GLenum BlendFunc[2];
+  GLenum DepthFunc;
+  GLint DepthMask;
+  GLenum CullFace;
+  GLint Viewport[4];
+  GLint Scissor[4];
+
+  bool bind(Binding &binding, const GLuint id);
+  bool bindIndexed(const GLenum target, const GLuint index,
+                   const IndexedBinding &binding);
+  void flushProgram();
+  void flushVertexArray();
+  void flushBuffer(const GLenum target, Binding &binding);
+  void setCap(const GLenum cap, const GLboolean enabled);
+
+public:
+  StateCache(StateCache const &) = delete;
+  void operator=(StateCache const &) = delete;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_STATE_HPP */
@@ -0,0 +1,142 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Transform Hierarchy Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglTransform.hpp"
+
+#include <stdexcept>
+
+#include "./mglCompose.hpp"
+
+namespace mgl {
+
+///////////////////////////////////////////////////////////// TransformHierarchy
+
+const GLuint TransformHierarchy::NO_PARENT;
+
+TransformHierarchy::TransformHierarchy() : Updated(0), Pass(0) {}
+
+TransformNode TransformHierarchy::addNode() {
+  const GLuint index = size();
+  Parents.push_back(NO_PARENT);
+  Translations.push_back(glm::vec3(0.0f));
+  Rotations.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+  Scales.push_back(glm::vec3(1.0f));
+  Locals.push_back(glm::mat4(1.0f));
+  Worlds.push_back(glm::mat4(1.0f));
+  Dirty.push_back(1);
+  Changed.push_back(Pass);
+  return {index};
+}
+
+TransformNode TransformHierarchy::addNode(const TransformNode parent) {
+  if (parent.index >= size()) {
+    throw std::runtime_error("Transform parent does not exist.");
+  }
+  TransformNode node = addNode();
+  Parents[node.index] = parent.index;
+  return node;
+}
+
+GLuint TransformHierarchy::size() const {
+  return static_cast<GLuint>(Parents.size());
+}
+
+void TransformHierarchy::clear() {
+  Parents.clear();
+  Translations.clear();
+  Rotations.clear();
+  Scales.clear();
+  Locals.clear();
+  Worlds.clear();
+  Dirty.clear();
+  Changed.clear();
+}
+
+void TransformHierarchy::setTranslation(const TransformNode node,
+                                        const glm::vec3 &translation) {
+  Translations[node.index] = translation;
+  Dirty[node.index] = 1;
+}
+
+void TransformHierarchy::setRotation(const TransformNode node,
+                                     const glm::quat &rotation) {
+  Rotations[node.index] = rotation;
+  Dirty[node.index] = 1;
+}
+
+void TransformHierarchy::setScale(const TransformNode node,
+                                  const glm::vec3 &scale) {
+  Scales[node.index] = scale;
+  Dirty[node.index] = 1;
+}
+
+void TransformHierarchy::setTransform(const TransformNode node,
+                                      const glm::vec3 &translation,
+                                      const glm::quat &rotation,
+                                      const glm::vec3 &scale) {
+  Translations[node.index] = translation;
+  Rotations[node.index] = rotation;
+  Scales[node.index] = scale;
+  Dirty[node.index] = 1;
+}
+
+const glm::vec3 &
+TransformHierarchy::getTranslation(const TransformNode node) const {
+  return Translations[node.index];
+}
+
+const glm::quat &
+TransformHierarchy::getRotation(const TransformNode node) const {
+  return Rotations[node.index];
+}
+
+const glm::vec3 &TransformHierarchy::getScale(const TransformNode node) const {
+  return Scales[node.index];
+}
+
+TransformNode TransformHierarchy::getParent(const TransformNode node) const {
+  return {Parents[node.index]};
+}
+
+const glm::mat4 &TransformHierarchy::getWorld(const TransformNode node) const {
+  return Worlds[node.index];
+}
+
+// Local matrices are composed in batches, one per run of consecutive dirty
+// nodes. Parents come first, so their world matrices are final when a child
+// is met.
+void TransformHierarchy::update() {
+  Pass++;
+  Updated = 0;
+  const GLuint n = size();
+  for (GLuint i = 0; i < n;) {
+    if (!Dirty[i]) {
+      i++;
+      continue;
+    }
+    GLuint last = i + 1;
+    while (last < n && Dirty[last])
+      last++;
+    composeTRS(&Translations[i], &Rotations[i], &Scales[i], &Locals[i],
+               last - i);
+    i = last;
+  }
+  for (GLuint i = 0; i < n; i++) {
+    const GLuint parent = Parents[i];
+    const bool moved = parent != NO_PARENT && Changed[parent] == Pass;
+    if (Dirty[i] || moved) {
+      Worlds[i] = parent == NO_PARENT ? Locals[i] : Worlds[parent] * Locals[i];
+      Dirty[i] = 0;
+      Changed[i] = Pass;
+      Updated++;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
@@ -0,0 +1,81 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Transform Hierarchy Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_TRANSFORM_HPP
+#define MGL_TRANSFORM_HPP
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <vector>
+
+namespace mgl {
+
+struct TransformNode;
+class TransformHierarchy;
+
+////////////////////////////////////////////////////////////////// TransformNode
+
+struct TransformNode {
+  GLuint index;
+};
+
+///////////////////////////////////////////////////////////// TransformHierarchy
+//
+// Nodes are stored as flat arrays, one per component, in the order they were
+// added. A parent must exist before its children, so that order is always
+// topological and update() is a single forward pass.
+//
+// Each node keeps its local translation, rotation and scale. Changing any of
+// them marks the node dirty; update() rebuilds the local matrix of dirty nodes
+// and the world matrix of every node whose local matrix or parent changed, so
+// moving a group node only recomputes its subtree.
+
+class TransformHierarchy final {
+public:
+  static const GLuint NO_PARENT = 0xFFFFFFFF;
+
+  GLuint Updated; // world matrices recomputed by the last update()
+
+  TransformHierarchy();
+
+  TransformNode addNode();
+  TransformNode addNode(const TransformNode parent);
+  GLuint size() const;
+  void clear();
+
+  void setTranslation(const TransformNode node, const glm::vec3 &translation);
+  void setRotation(const TransformNode node, const glm::quat &rotation);
+  void setScale(const TransformNode node, const glm::vec3 &scale);
+  void setTransform(const TransformNode node, const glm::vec3 &translation,
+                    const glm::quat &rotation, const glm::vec3 &scale);
+  const glm::vec3 &getTranslation(const TransformNode node) const;
+  const glm::quat &getRotation(const TransformNode node) const;
+  const glm::vec3 &getScale(const TransformNode node) const;
+  TransformNode getParent(const TransformNode node) const;
+
+  void update();
+  const glm::mat4 &getWorld(const TransformNode node) const;
+
+private:
+  std::vector<GLuint> Parents;
+  std::vector<glm::vec3> Translations;
+  std::vector<glm::quat> Rotations;
+  std::vector<glm::vec3> Scales;
+  std::vector<glm::mat4> Locals;
+  std::vector<glm::mat4> Worlds;
+  std::vector<GLubyte> Dirty;
+  std::vector<GLuint> Changed; // last pass that changed the world matrix
+  GLuint Pass;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_TRANSFORM_HPP */
@@ -0,0 +1,59 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Uniform Buffer Ring Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_UNIFORM_BUFFER_HPP
+#define MGL_UNIFORM_BUFFER_HPP
+
+#include <GL/glew.h>
+
+namespace mgl {
+
+class UniformBufferRing;
+
+////////////////////////////////////////////////////////////// UniformBufferRing
+//
+// A uniform buffer split into FRAMES regions, persistently and coherently
+// mapped (OpenGL 4.4). Each frame writes its blocks into its own region while
+// the GPU may still be reading the previous ones, so no glBufferSubData is
+// ever issued. A fence placed at endFrame() guards each region; beginFrame()
+// only waits on it if the GPU is more than FRAMES-1 frames behind.
+
+class UniformBufferRing final {
+public:
+  static const GLuint FRAMES = 3;
+
+  GLuint BufferId;
+  GLuint Stalls;
+
+  explicit UniformBufferRing(const GLsizeiptr frame_size);
+  ~UniformBufferRing();
+
+  UniformBufferRing(const UniformBufferRing &) = delete;
+  UniformBufferRing &operator=(const UniformBufferRing &) = delete;
+
+  void beginFrame();
+  GLintptr write(const void *data, const GLsizeiptr size);
+  void bindRange(const GLuint binding_point, const GLintptr offset,
+                 const GLsizeiptr size);
+  GLintptr push(const GLuint binding_point, const void *data,
+                const GLsizeiptr size);
+  void endFrame();
+
+private:
+  GLubyte *Mapped;
+  GLsizeiptr FrameSize;
+  GLint Alignment;
+  GLuint Frame;
+  GLintptr Offset;
+  GLsync Fences[FRAMES];
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_UNIFORM_BUFFER_HPP */
@@ -0,0 +1,80 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Vertex Layout Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglVertexLayout.hpp"
+
+#include <algorithm>
+
+namespace mgl {
+
+struct FormatInfo {
+  GLint components;
+  GLenum type;
+  GLboolean normalized;
+  GLuint size;
+};
+
+// Indexed by VertexFormat
+static const FormatInfo FORMATS[] = {
+    {1, GL_FLOAT, GL_FALSE, 4},
+    {2, GL_FLOAT, GL_FALSE, 8},
+    {3, GL_FLOAT, GL_FALSE, 12},
+    {4, GL_FLOAT, GL_FALSE, 16},
+    {2, GL_HALF_FLOAT, GL_FALSE, 4},
+    {4, GL_HALF_FLOAT, GL_FALSE, 8},
+    {2, GL_SHORT, GL_TRUE, 4},
+    {4, GL_SHORT, GL_TRUE, 8},
+    {4, GL_INT_2_10_10_10_REV, GL_TRUE, 4},
+    {4, GL_UNSIGNED_BYTE, GL_TRUE, 4}};
+
+static const FormatInfo &getInfo(const VertexFormat format) {
+  return FORMATS[static_cast<int>(format)];
+}
+
+/////////////////////////////////////////////////////////////////// VertexLayout
+
+VertexLayout::VertexLayout() : Stride(0) {}
+
+VertexLayout &VertexLayout::add(const GLuint index,
+                                const VertexFormat format) {
+  GLuint offset = 0;
+  for (auto &a : Attributes)
+    offset = std::max(offset, a.offset + getSize(a.format));
+  return add(index, format, offset);
+}
+
+VertexLayout &VertexLayout::add(const GLuint index, const VertexFormat format,
+                                const GLuint offset) {
+  Attributes.push_back({index, format, offset});
+  Stride = std::max(Stride, static_cast<GLsizei>(offset + getSize(format)));
+  return *this;
+}
+
+VertexLayout &VertexLayout::setStride(const GLsizei stride) {
+  Stride = stride;
+  return *this;
+}
+
+GLuint VertexLayout::getSize(const VertexFormat format) {
+  return getInfo(format).size;
+}
+
+// Sets up the attribute formats of the bound VAO; the buffer itself is
+// attached with glBindVertexBuffer(binding, ...).
+void VertexLayout::configure(const GLuint binding) const {
+  for (auto &a : Attributes) {
+    const FormatInfo &info = getInfo(a.format);
+    glEnableVertexAttribArray(a.index);
+    glVertexAttribFormat(a.index, info.components, info.type, info.normalized,
+                         a.offset);
+    glVertexAttribBinding(a.index, binding);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
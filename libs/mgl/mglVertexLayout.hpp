@@ -0,0 +1,71 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Vertex Layout Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_VERTEX_LAYOUT_HPP
+#define MGL_VERTEX_LAYOUT_HPP
+
+#include <GL/glew.h>
+
+#include <vector>
+
+namespace mgl {
+
+class VertexLayout;
+
+/////////////////////////////////////////////////////////////////// VertexFormat
+//
+// Storage format of one attribute. Every format is read by the shader as a
+// float vector; missing components default to (0, 0, 0, 1). Normalized
+// formats map integers to [0, 1] (UNORM) or [-1, 1] (SNORM). The packed
+// formats are filled with glm/gtc/packing.hpp: packHalf2x16, packSnorm2x16,
+// packSnorm3x10_1x2 and packUnorm4x8.
+
+enum class VertexFormat {
+  FLOAT1,
+  FLOAT2,
+  FLOAT3,
+  FLOAT4,
+  HALF2,             // 2x 16-bit float, 4 bytes
+  HALF4,             // 4x 16-bit float, 8 bytes
+  SNORM16_2,         // 2x 16-bit signed normalized, 4 bytes
+  SNORM16_4,         // 4x 16-bit signed normalized, 8 bytes
+  SNORM_10_10_10_2,  // normals and tangents, 4 bytes
+  UNORM8_4           // colors, 4 bytes
+};
+
+/////////////////////////////////////////////////////////////////// VertexLayout
+//
+// Describes the attributes read from one vertex buffer binding. Attributes are
+// either packed one after the other or placed at explicit offsets, to match a
+// struct. The stride is the end of the last attribute unless set explicitly.
+
+class VertexLayout final {
+public:
+  struct Attribute {
+    GLuint index;
+    VertexFormat format;
+    GLuint offset;
+  };
+  std::vector<Attribute> Attributes;
+  GLsizei Stride;
+
+  VertexLayout();
+
+  VertexLayout &add(const GLuint index, const VertexFormat format);
+  VertexLayout &add(const GLuint index, const VertexFormat format,
+                    const GLuint offset);
+  VertexLayout &setStride(const GLsizei stride);
+  void configure(const GLuint binding) const;
+
+  static GLuint getSize(const VertexFormat format);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_VERTEX_LAYOUT_HPP */
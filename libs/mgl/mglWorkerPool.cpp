@@ -0,0 +1,76 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Worker Pool Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglWorkerPool.hpp"
+
+#include <algorithm>
+
+namespace mgl {
+
+///////////////////////////////////////////////////////////////////// WorkerPool
+
+WorkerPool::WorkerPool(unsigned int workers)
+    : Job(nullptr), Generation(0), Pending(0), Quit(false) {
+  if (workers == 0)
+    workers = std::max(1u, std::thread::hardware_concurrency());
+  for (unsigned int i = 1; i < workers; i++) {
+    Threads.emplace_back(&WorkerPool::loop, this, i);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    Quit = true;
+  }
+  Start.notify_all();
+  for (auto &t : Threads)
+    t.join();
+}
+
+unsigned int WorkerPool::size() {
+  return static_cast<unsigned int>(Threads.size()) + 1;
+}
+
+void WorkerPool::loop(unsigned int worker) {
+  unsigned long seen = 0;
+  for (;;) {
+    const std::function<void(unsigned int)> *job;
+    {
+      std::unique_lock<std::mutex> lock(Mutex);
+      Start.wait(lock, [&] { return Quit || Generation != seen; });
+      if (Quit)
+        return;
+      seen = Generation;
+      job = Job;
+    }
+    (*job)(worker);
+    {
+      std::lock_guard<std::mutex> lock(Mutex);
+      if (--Pending == 0)
+        Done.notify_one();
+    }
+  }
+}
+
+void WorkerPool::run(const std::function<void(unsigned int worker)> &job) {
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    Job = &job;
+    Pending = static_cast<unsigned int>(Threads.size());
+    Generation++;
+  }
+  Start.notify_all();
+  job(0);
+  std::unique_lock<std::mutex> lock(Mutex);
+  Done.wait(lock, [&] { return Pending == 0; });
+  Job = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
@@ -0,0 +1,55 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Worker Pool Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_WORKER_POOL_HPP
+#define MGL_WORKER_POOL_HPP
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mgl {
+
+class WorkerPool;
+
+///////////////////////////////////////////////////////////////////// WorkerPool
+//
+// Persistent threads for fork-join work done every frame. run() hands the same
+// job to every worker, the calling thread being worker 0, and returns once all
+// of them are done. Jobs must not make GL calls.
+
+class WorkerPool final {
+public:
+  explicit WorkerPool(unsigned int workers = 0); // 0 = one per hardware thread
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  unsigned int size();
+  void run(const std::function<void(unsigned int worker)> &job);
+
+private:
+  std::vector<std::thread> Threads;
+  std::mutex Mutex;
+  std::condition_variable Start;
+  std::condition_variable Done;
+  const std::function<void(unsigned int)> *Job;
+  unsigned long Generation;
+  unsigned int Pending;
+  bool Quit;
+
+  void loop(unsigned int worker);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_WORKER_POOL_HPP */